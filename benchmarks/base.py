@@ -20,7 +20,10 @@ from threading import Thread
 import time
 from optparse import OptionParser
 
-from greplin import scales
+try:
+    from greplin import scales
+except ImportError:
+    scales = None
 
 dirname = os.path.dirname(os.path.abspath(__file__))
 sys.path.append(dirname)
@@ -31,6 +34,8 @@ from cassandra.cluster import Cluster
 from cassandra.io.asyncorereactor import AsyncoreConnection
 from cassandra.policies import HostDistance
 
+import standin_server
+
 log = logging.getLogger()
 handler = logging.StreamHandler()
 handler.setFormatter(logging.Formatter("%(asctime)s [%(levelname)s] %(name)s: %(message)s"))
@@ -58,10 +63,10 @@ KEYSPACE = "testkeyspace" + str(int(time.time()))
 TABLE = "testtable"
 
 
-def setup(hosts):
+def setup(hosts, port=9042):
     log.info("Using 'cassandra' package from %s", cassandra.__path__)
 
-    cluster = Cluster(hosts)
+    cluster = Cluster(hosts, port=port)
     cluster.set_core_connections_per_host(HostDistance.LOCAL, 1)
     try:
         session = cluster.connect()
@@ -88,90 +93,158 @@ def setup(hosts):
         cluster.shutdown()
 
 
-def teardown(hosts):
-    cluster = Cluster(hosts)
+def teardown(hosts, port=9042):
+    cluster = Cluster(hosts, port=port)
     cluster.set_core_connections_per_host(HostDistance.LOCAL, 1)
     session = cluster.connect()
     session.execute("DROP KEYSPACE " + KEYSPACE)
     cluster.shutdown()
 
 
-def benchmark(thread_class):
-    options, args = parse_options()
-    for conn_class in options.supported_reactors:
-        setup(options.hosts)
-        log.info("==== %s ====" % (conn_class.__name__,))
+class LatencyRecorder(object):
+    """
+    Records the latency of every request made through `session`.
+    """
 
-        kwargs = {'metrics_enabled': options.enable_metrics,
-                  'connection_class': conn_class}
-        if options.protocol_version:
-            kwargs['protocol_version'] = options.protocol_version
-        cluster = Cluster(options.hosts, **kwargs)
-        session = cluster.connect(KEYSPACE)
+    def __init__(self, session):
+        self.latencies = []
+        self.errors = []
 
-        log.debug("Sleeping for two seconds...")
-        time.sleep(2.0)
+        # Session.execute() goes through execute_async() as well
+        execute_async = session.execute_async
 
-        query = session.prepare("""
-            INSERT INTO {table} (thekey, col1, col2) VALUES (?, ?, ?)
-            """.format(table=TABLE))
-        values = ('key', 'a', 'b')
+        def timed_execute_async(*args, **kwargs):
+            start = time.time()
+            future = execute_async(*args, **kwargs)
+            future.add_callbacks(self._record, self._record_error, callback_args=(start,), errback_args=(start,))
+            return future
 
-        per_thread = options.num_ops // options.threads
-        threads = []
+        session.execute_async = timed_execute_async
 
-        log.debug("Beginning inserts...")
-        start = time.time()
-        try:
-            for i in range(options.threads):
-                thread = thread_class(
-                    i, session, query, values, per_thread,
-                    cluster.protocol_version, options.profile)
-                thread.daemon = True
-                threads.append(thread)
+    def _record(self, _, start):
+        self.latencies.append(time.time() - start)
 
-            for thread in threads:
-                thread.start()
+    def _record_error(self, exc, start):
+        self.errors.append(exc)
+        self.latencies.append(time.time() - start)
 
-            for thread in threads:
-                while thread.is_alive():
-                    thread.join(timeout=0.5)
+    def percentiles(self, *ps):
+        latencies = sorted(self.latencies)
+        if not latencies:
+            return [0.0] * len(ps)
+        return [latencies[min(len(latencies) - 1, int(len(latencies) * p))] for p in ps]
 
-            end = time.time()
+
+def benchmark(thread_class):
+    options, args = parse_options()
+    results = []
+    for conn_class in options.supported_reactors:
+        server = None
+        if options.stand_in:
+            server, options.port = standin_server.run_in_process(
+                rows=options.rows, latency_ms=options.latency_ms, jitter_ms=options.jitter_ms,
+                error_rate=options.error_rate, error=options.error, seed=options.seed)
+
+        try:
+            results.append((conn_class.__name__, run(thread_class, conn_class, options)))
         finally:
-            cluster.shutdown()
-            teardown(options.hosts)
-
-        total = end - start
-        log.info("Total time: %0.2fs" % total)
-        log.info("Average throughput: %0.2f/sec" % (options.num_ops / total))
-        if options.enable_metrics:
-            stats = scales.getStats()['cassandra']
-            log.info("Connection errors: %d", stats['connection_errors'])
-            log.info("Write timeouts: %d", stats['write_timeouts'])
-            log.info("Read timeouts: %d", stats['read_timeouts'])
-            log.info("Unavailables: %d", stats['unavailables'])
-            log.info("Other errors: %d", stats['other_errors'])
-            log.info("Retries: %d", stats['retries'])
-
-            request_timer = stats['request_timer']
-            log.info("Request latencies:")
-            log.info("  min: %0.4fs", request_timer['min'])
-            log.info("  max: %0.4fs", request_timer['max'])
-            log.info("  mean: %0.4fs", request_timer['mean'])
-            log.info("  stddev: %0.4fs", request_timer['stddev'])
-            log.info("  median: %0.4fs", request_timer['median'])
-            log.info("  75th: %0.4fs", request_timer['75percentile'])
-            log.info("  95th: %0.4fs", request_timer['95percentile'])
-            log.info("  98th: %0.4fs", request_timer['98percentile'])
-            log.info("  99th: %0.4fs", request_timer['99percentile'])
-            log.info("  99.9th: %0.4fs", request_timer['999percentile'])
+            if server:
+                server.terminate()
+                server.join()
+
+    log.info("==== Summary ====")
+    log.info("%-20s %10s %8s %9s %9s %9s %9s %9s",
+             "reactor", "ops/sec", "errors", "p50", "p90", "p99", "p99.9", "max")
+    for name, (ops_per_sec, recorder) in results:
+        log.info("%-20s %10.2f %8d %8.2fms %8.2fms %8.2fms %8.2fms %8.2fms",
+                 name, ops_per_sec, len(recorder.errors),
+                 *[l * 1000 for l in recorder.percentiles(0.5, 0.9, 0.99, 0.999, 1.0)])
+
+
+def run(thread_class, conn_class, options):
+    """
+    Runs one benchmark with `conn_class` and returns the throughput in
+    operations per second and the :class:`LatencyRecorder` for the run.
+    """
+    setup(options.hosts, options.port)
+    log.info("==== %s ====" % (conn_class.__name__,))
+
+    kwargs = {'metrics_enabled': options.enable_metrics,
+              'connection_class': conn_class,
+              'port': options.port}
+    if options.protocol_version:
+        kwargs['protocol_version'] = options.protocol_version
+    cluster = Cluster(options.hosts, **kwargs)
+    session = cluster.connect(KEYSPACE)
+    recorder = LatencyRecorder(session)
+
+    log.debug("Sleeping for two seconds...")
+    time.sleep(2.0)
+
+    query = session.prepare("""
+        INSERT INTO {table} (thekey, col1, col2) VALUES (?, ?, ?)
+        """.format(table=TABLE))
+    values = ('key', 'a', 'b')
+
+    per_thread = options.num_ops // options.threads
+    threads = []
+
+    log.debug("Beginning inserts...")
+    start = time.time()
+    try:
+        for i in range(options.threads):
+            thread = thread_class(
+                i, session, query, values, per_thread,
+                cluster.protocol_version, options.profile)
+            thread.daemon = True
+            threads.append(thread)
+
+        for thread in threads:
+            thread.start()
+
+        for thread in threads:
+            while thread.is_alive():
+                thread.join(timeout=0.5)
+
+        end = time.time()
+    finally:
+        cluster.shutdown()
+        teardown(options.hosts, options.port)
+
+    total = end - start
+    log.info("Total time: %0.2fs" % total)
+    log.info("Average throughput: %0.2f/sec" % (options.num_ops / total))
+    if options.enable_metrics:
+        stats = scales.getStats()['cassandra']
+        log.info("Connection errors: %d", stats['connection_errors'])
+        log.info("Write timeouts: %d", stats['write_timeouts'])
+        log.info("Read timeouts: %d", stats['read_timeouts'])
+        log.info("Unavailables: %d", stats['unavailables'])
+        log.info("Other errors: %d", stats['other_errors'])
+        log.info("Retries: %d", stats['retries'])
+
+        request_timer = stats['request_timer']
+        log.info("Request latencies:")
+        log.info("  min: %0.4fs", request_timer['min'])
+        log.info("  max: %0.4fs", request_timer['max'])
+        log.info("  mean: %0.4fs", request_timer['mean'])
+        log.info("  stddev: %0.4fs", request_timer['stddev'])
+        log.info("  median: %0.4fs", request_timer['median'])
+        log.info("  75th: %0.4fs", request_timer['75percentile'])
+        log.info("  95th: %0.4fs", request_timer['95percentile'])
+        log.info("  98th: %0.4fs", request_timer['98percentile'])
+        log.info("  99th: %0.4fs", request_timer['99percentile'])
+        log.info("  99.9th: %0.4fs", request_timer['999percentile'])
+
+    return options.num_ops / total, recorder
 
 
 def parse_options():
     parser = OptionParser()
     parser.add_option('-H', '--hosts', default='127.0.0.1',
                       help='cassandra hosts to connect to (comma-separated list) [default: %default]')
+    parser.add_option('-P', '--port', type='int', default=9042,
+                      help='native protocol port of the hosts [default: %default]')
     parser.add_option('-t', '--threads', type='int', default=1,
                       help='number of threads [default: %default]')
     parser.add_option('-n', '--num-ops', type='int', default=10000,
@@ -190,13 +263,34 @@ def parse_options():
                       help='Profile the run')
     parser.add_option('--protocol-version', type='int', dest='protocol_version',
                       help='Native protocol version to use')
+    parser.add_option('--stand-in', action='store_true', dest='stand_in',
+                      help='run against a local stand-in server instead of Cassandra '
+                           '(see standin_server.py); --hosts and --port are ignored')
+    parser.add_option('--rows', type='int', default=10,
+                      help='stand-in: rows returned for each SELECT [default: %default]')
+    parser.add_option('--latency-ms', type='float', default=0.0, dest='latency_ms',
+                      help='stand-in: fixed delay added to each response [default: %default]')
+    parser.add_option('--jitter-ms', type='float', default=0.0, dest='jitter_ms',
+                      help='stand-in: maximum random delay added on top of --latency-ms [default: %default]')
+    parser.add_option('--error-rate', type='float', default=0.0, dest='error_rate',
+                      help='stand-in: fraction of requests answered with an error [default: %default]')
+    parser.add_option('--error', default='unavailable', choices=sorted(standin_server.ERRORS),
+                      help='stand-in: error to inject: %s [default: %%default]' % ', '.join(sorted(standin_server.ERRORS)))
+    parser.add_option('--seed', type='int', default=0,
+                      help='stand-in: seed for latency and error injection [default: %default]')
 
     options, args = parser.parse_args()
 
     options.hosts = options.hosts.split(',')
+    if options.stand_in:
+        options.hosts = ['127.0.0.1']
 
     log.setLevel(options.log_level.upper())
 
+    if options.enable_metrics and scales is None:
+        log.error("The scales library is required for metrics")
+        sys.exit(1)
+
     if options.asyncore_only:
         options.supported_reactors = [AsyncoreConnection]
     elif options.libev_only:
@@ -237,3 +331,17 @@ class BenchmarkThread(Thread):
         if self.profiler:
             self.profiler.disable()
             self.profiler.dump_stats('profile-%d' % self.thread_num)
+
+    def wait_for(self, future):
+        # failures are counted by the LatencyRecorder; keep going so that
+        # injected errors don't end the run
+        try:
+            future.result()
+        except Exception as exc:
+            log.debug("Error on insert: %r", exc)
+
+    def execute(self):
+        try:
+            self.session.execute(self.query, self.values)
+        except Exception as exc:
+            log.debug("Error on insert: %r", exc)
@@ -37,7 +37,7 @@ class Runner(BenchmarkThread):
     def insert_next(self, previous_result=sentinel):
         if previous_result is not sentinel:
             if isinstance(previous_result, BaseException):
-                log.error("Error on insert: %r", previous_result)
+                log.debug("Error on insert: %r", previous_result)
             if next(self.num_finished) >= self.num_queries:
                 self.event.set()
 
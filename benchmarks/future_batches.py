@@ -31,7 +31,7 @@ class Runner(BenchmarkThread):
                 # clear the existing queue
                 while True:
                     try:
-                        futures.get_nowait().result()
+                        self.wait_for(futures.get_nowait())
                     except queue.Empty:
                         break
 
@@ -40,7 +40,7 @@ class Runner(BenchmarkThread):
 
         while True:
             try:
-                futures.get_nowait().result()
+                self.wait_for(futures.get_nowait())
             except queue.Empty:
                 break
 
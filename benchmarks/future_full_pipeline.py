@@ -29,18 +29,18 @@ class Runner(BenchmarkThread):
         for i in range(self.num_queries):
             if i >= 120:
                 old_future = futures.get_nowait()
-                old_future.result()
+                self.wait_for(old_future)
 
             future = self.session.execute_async(self.query, self.values)
             futures.put_nowait(future)
 
         while True:
             try:
-                futures.get_nowait().result()
+                self.wait_for(futures.get_nowait())
             except queue.Empty:
                 break
 
-        self.finish_profile
+        self.finish_profile()
 
 
 if __name__ == "__main__":
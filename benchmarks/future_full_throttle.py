@@ -30,7 +30,7 @@ class Runner(BenchmarkThread):
             futures.append(future)
 
         for future in futures:
-            future.result()
+            self.wait_for(future)
 
         self.finish_profile()
 
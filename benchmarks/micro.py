@@ -0,0 +1,662 @@
+# Copyright 2013-2015 DataStax, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Micro-benchmarks for the driver's hot paths, below the cluster level:
+
+* ``murmur3``: token hashing with the ``cassandra.murmur3`` extension
+* ``libev``: read event dispatch through ``cassandra.io.libevwrapper``
+* ``process_io_buffer``: splitting a stream of responses into frames and
+  decoding them with ``Connection.process_io_buffer()``, uncompressed and
+  with every compression library that is installed
+* ``recv_results_rows``: decoding the body of ROWS results
+* ``bind``: ``PreparedStatement.bind()`` for a mix of column types
+
+Responses come from the frame corpus in ``benchmarks/corpus``: one file of
+wire-format RESULT frames per result shape and page size.  The corpus is
+generated from a fixed seed with ``--write-corpus``; compressed variants
+are built from it when the benchmarks start.
+
+Each benchmark reports its throughput, the peak number of bytes allocated
+while running one operation (``bytes/op``, needs :mod:`tracemalloc`) and
+the number of memory blocks one operation leaves allocated while its result
+is held (``blocks/op``, needs ``sys.getallocatedblocks()``), which tracks the
+objects it creates and keeps.  Both need CPython 3.4 or later and are shown
+as ``-`` elsewhere.  Results can be written as JSON and two runs compared,
+for example before and after a change, or with and without the C
+extensions built::
+
+    python benchmarks/micro.py -o before.json
+    python benchmarks/micro.py -o after.json
+    python benchmarks/micro.py --compare before.json after.json
+"""
+
+from collections import namedtuple, OrderedDict
+from datetime import datetime, timedelta
+from decimal import Decimal
+import gc
+import io
+import json
+import logging
+from optparse import OptionParser
+import os
+import platform
+import random
+import socket
+import sys
+import timeit
+import uuid
+
+try:
+    import tracemalloc
+except ImportError:
+    tracemalloc = None
+
+dirname = os.path.dirname(os.path.abspath(__file__))
+# prefer the tree this script is in, so that runs from two checkouts
+# compare two builds
+sys.path.insert(0, os.path.join(dirname, '..'))
+
+import cassandra
+from cassandra.connection import Connection, HEADER_DIRECTION_TO_CLIENT, locally_supported_compressions
+from cassandra.cqltypes import (AsciiType, BooleanType, BytesType, DateType, DecimalType,
+                                DoubleType, InetAddressType, Int32Type, IntegerType, ListType,
+                                LongType, MapType, SetType, TimeUUIDType, TupleType, UserType,
+                                UTF8Type, UUIDType)
+from cassandra.marshal import header_pack, header_unpack, int32_pack, int32_unpack, v3_header_pack, v3_header_unpack
+from cassandra.protocol import (COMPRESSED_FLAG, RESULT_KIND_ROWS, RESULT_KIND_VOID, ResultMessage,
+                                write_int, write_short, write_string, write_value)
+from cassandra.query import PreparedStatement
+
+try:
+    from cassandra.murmur3 import murmur3
+except ImportError:
+    murmur3 = None
+
+try:
+    from cassandra.io import libevwrapper
+except ImportError:
+    libevwrapper = None
+
+log = logging.getLogger()
+handler = logging.StreamHandler()
+handler.setFormatter(logging.Formatter("%(asctime)s [%(levelname)s] %(name)s: %(message)s"))
+log.addHandler(handler)
+
+CORPUS_DIR = os.path.join(dirname, 'corpus')
+
+# roughly what a reactor drains from the socket between two calls
+# to process_io_buffer() when responses are arriving back to back
+CHUNK_SIZE = 64 * 1024
+
+ADDRESS_TYPE = UserType.make_udt_class(
+    'bench', 'address', (('street', UTF8Type), ('zipcode', Int32Type)), None)
+
+TEXT_COLUMNS = (
+    ('thekey', UTF8Type), ('col1', UTF8Type), ('col2', UTF8Type))
+
+MIXED_COLUMNS = (
+    ('id', UUIDType), ('created', TimeUUIDType), ('name', UTF8Type), ('code', AsciiType),
+    ('count', Int32Type), ('total', LongType), ('score', DoubleType), ('price', DecimalType),
+    ('big', IntegerType), ('active', BooleanType), ('updated', DateType),
+    ('address', InetAddressType), ('payload', BytesType))
+
+COLLECTION_COLUMNS = (
+    ('id', Int32Type), ('tags', ListType.apply_parameters([UTF8Type])),
+    ('ids', SetType.apply_parameters([Int32Type])),
+    ('counts', MapType.apply_parameters([UTF8Type, LongType])),
+    ('point', TupleType.apply_parameters([Int32Type, UTF8Type])),
+    ('home', ADDRESS_TYPE))
+
+CorpusSpec = namedtuple('CorpusSpec', ('protocol_version', 'columns', 'num_rows', 'page_size'))
+
+# columns=None means VOID results (write acknowledgements); then
+# num_rows is the number of frames
+CORPUS = OrderedDict([
+    ('void.v3', CorpusSpec(3, None, 1000, None)),
+    ('text-p100.v3', CorpusSpec(3, TEXT_COLUMNS, 1000, 100)),
+    ('text-p1000.v3', CorpusSpec(3, TEXT_COLUMNS, 1000, 1000)),
+    ('mixed-p100.v3', CorpusSpec(3, MIXED_COLUMNS, 500, 100)),
+    ('mixed-p500.v2', CorpusSpec(2, MIXED_COLUMNS, 500, 500)),
+    ('collections-p100.v3', CorpusSpec(3, COLLECTION_COLUMNS, 500, 100)),
+])
+
+CORPUS_SEED = 1234
+
+
+_simple_values = {
+    AsciiType: lambda rng: 'code-%d' % rng.randint(0, 10 ** 6),
+    UTF8Type: lambda rng: u'value-\u00e9-%d' % rng.randint(0, 10 ** 9),
+    BytesType: lambda rng: bytes(bytearray(rng.randint(0, 255) for _ in range(rng.randint(0, 48)))),
+    BooleanType: lambda rng: rng.random() < 0.5,
+    Int32Type: lambda rng: rng.randint(-2 ** 31, 2 ** 31 - 1),
+    LongType: lambda rng: rng.randint(-2 ** 63, 2 ** 63 - 1),
+    DoubleType: lambda rng: rng.uniform(-1e6, 1e6),
+    DecimalType: lambda rng: Decimal(rng.randint(-10 ** 8, 10 ** 8)).scaleb(-4),
+    IntegerType: lambda rng: rng.getrandbits(96) - 2 ** 95,
+    UUIDType: lambda rng: uuid.UUID(int=rng.getrandbits(128), version=4),
+    TimeUUIDType: lambda rng: uuid.UUID(int=rng.getrandbits(128), version=1),
+    DateType: lambda rng: datetime(2015, 1, 1) + timedelta(milliseconds=rng.randint(0, 10 ** 11)),
+    InetAddressType: lambda rng: '10.%d.%d.%d' % (rng.randint(0, 255), rng.randint(0, 255), rng.randint(0, 255)),
+}
+
+
+def make_value(rng, typ):
+    if issubclass(typ, UserType):
+        return typ.tuple_type(*[make_value(rng, subtype) for subtype in typ.subtypes])
+    elif issubclass(typ, TupleType):
+        return tuple(make_value(rng, subtype) for subtype in typ.subtypes)
+    elif issubclass(typ, ListType):
+        return [make_value(rng, typ.subtypes[0]) for _ in range(rng.randint(0, 5))]
+    elif issubclass(typ, SetType):
+        return sorted(set(make_value(rng, typ.subtypes[0]) for _ in range(rng.randint(0, 5))))
+    elif issubclass(typ, MapType):
+        keytype, valtype = typ.subtypes
+        return OrderedDict((make_value(rng, keytype), make_value(rng, valtype))
+                           for _ in range(rng.randint(0, 5)))
+    return _simple_values[typ](rng)
+
+
+def make_row(rng, columns):
+    # the first column is the key; the others are sometimes null
+    return [make_value(rng, typ) if i == 0 or rng.random() >= 0.05 else None
+            for i, (_, typ) in enumerate(columns)]
+
+
+_type_codes = dict((typ, code) for code, typ in sorted(ResultMessage._type_codes.items()))
+
+
+def write_type(f, typ):
+    if issubclass(typ, UserType):
+        write_short(f, _type_codes[UserType])
+        write_string(f, typ.keyspace)
+        write_string(f, typ.typename)
+        write_short(f, len(typ.subtypes))
+        for name, subtype in zip(typ.fieldnames, typ.subtypes):
+            write_string(f, name)
+            write_type(f, subtype)
+    elif issubclass(typ, TupleType):
+        write_short(f, _type_codes[TupleType])
+        write_short(f, len(typ.subtypes))
+        for subtype in typ.subtypes:
+            write_type(f, subtype)
+    else:
+        for collection_type in (ListType, SetType, MapType):
+            if issubclass(typ, collection_type):
+                write_short(f, _type_codes[collection_type])
+                for subtype in typ.subtypes:
+                    write_type(f, subtype)
+                return
+        write_short(f, _type_codes[typ])
+
+
+def make_frame(protocol_version, stream_id, body, flags=0):
+    pack = v3_header_pack if protocol_version >= 3 else header_pack
+    return (pack(HEADER_DIRECTION_TO_CLIENT | protocol_version, flags, stream_id, ResultMessage.opcode) +
+            int32_pack(len(body)) + body)
+
+
+def rows_body(protocol_version, columns, rows, paging_state):
+    f = io.BytesIO()
+    write_int(f, RESULT_KIND_ROWS)
+    flags = ResultMessage._FLAGS_GLOBAL_TABLES_SPEC
+    if paging_state is not None:
+        flags |= ResultMessage._HAS_MORE_PAGES_FLAG
+    write_int(f, flags)
+    write_int(f, len(columns))
+    if paging_state is not None:
+        write_value(f, paging_state)
+    write_string(f, 'bench')
+    write_string(f, 'table')
+    for name, typ in columns:
+        write_string(f, name)
+        write_type(f, typ)
+    write_int(f, len(rows))
+    for row in rows:
+        for (_, typ), value in zip(columns, row):
+            write_value(f, None if value is None else typ.to_binary(value, protocol_version))
+    return f.getvalue()
+
+
+def generate_corpus(spec, seed=CORPUS_SEED):
+    rng = random.Random(seed)
+    frames = []
+    if spec.columns is None:
+        body = int32_pack(RESULT_KIND_VOID)
+        for stream_id in range(spec.num_rows):
+            frames.append(make_frame(spec.protocol_version, stream_id, body))
+        return frames
+
+    rows = [make_row(rng, spec.columns) for _ in range(spec.num_rows)]
+    for stream_id, start in enumerate(range(0, len(rows), spec.page_size)):
+        end = start + spec.page_size
+        paging_state = int32_pack(end) if end < len(rows) else None
+        frames.append(make_frame(spec.protocol_version, stream_id,
+                                 rows_body(spec.protocol_version, spec.columns, rows[start:end], paging_state)))
+    return frames
+
+
+def write_corpus(directory):
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+    for name, spec in CORPUS.items():
+        path = os.path.join(directory, name + '.frames')
+        frames = generate_corpus(spec)
+        with open(path, 'wb') as f:
+            f.write(b''.join(frames))
+        log.info("Wrote %d frames to %s", len(frames), path)
+
+
+def split_frames(data):
+    """
+    Splits a recorded stream of responses into frames, returning the
+    protocol version and the list of frames.
+    """
+    protocol_version = ord(data[0:1]) & 0x7f
+    header_length = 5 if protocol_version >= 3 else 4
+    frames = []
+    pos = 0
+    while pos < len(data):
+        body_len = int32_unpack(data[pos + header_length:pos + header_length + 4])
+        end = pos + header_length + 4 + body_len
+        frames.append(data[pos:end])
+        pos = end
+    return protocol_version, frames
+
+
+def load_corpus(directory):
+    corpus = OrderedDict()
+    for name in CORPUS:
+        path = os.path.join(directory, name + '.frames')
+        if not os.path.exists(path):
+            log.warning("Corpus file %s is missing; run with --write-corpus to create it", path)
+            continue
+        with open(path, 'rb') as f:
+            corpus[name] = split_frames(f.read())
+    return corpus
+
+
+def compress_frames(protocol_version, frames, compress):
+    if protocol_version >= 3:
+        unpack, header_length = v3_header_unpack, 5
+    else:
+        unpack, header_length = header_unpack, 4
+    compressed = []
+    for frame in frames:
+        version, flags, stream_id, opcode = unpack(frame[:header_length])
+        compressed.append(make_frame(protocol_version, stream_id, compress(frame[header_length + 4:]),
+                                     flags | COMPRESSED_FLAG))
+    return compressed
+
+
+Benchmark = namedtuple('Benchmark', ('name', 'unit', 'ops_per_call', 'rows_per_call', 'func'))
+
+
+def murmur3_benchmarks():
+    if murmur3 is None:
+        log.warning("Skipping murmur3 benchmarks: the cassandra.murmur3 extension is not built")
+        return []
+
+    rng = random.Random(CORPUS_SEED)
+    benchmarks = []
+    for size in (8, 16, 64, 256):
+        keys = [bytes(bytearray(rng.randint(0, 255) for _ in range(size))) for _ in range(1000)]
+        benchmarks.append(Benchmark('murmur3[%dB]' % size, 'hashes', len(keys), None,
+                                    lambda keys=keys: list(map(murmur3, keys))))
+    return benchmarks
+
+
+def libev_benchmarks():
+    if libevwrapper is None:
+        log.warning("Skipping libev benchmarks: the cassandra.io.libevwrapper extension is not built")
+        return []
+
+    events = 1000
+    loop = libevwrapper.Loop()
+    writer, reader = socket.socketpair()
+    writer.setblocking(0)
+    reader.setblocking(0)
+    received = [0]
+
+    def handle_read(watcher, revents):
+        reader.recv(4096)
+        received[0] += 1
+        if received[0] >= events:
+            # the loop returns once it has no active watchers left
+            watcher.stop()
+        else:
+            writer.send(b'x')
+
+    watcher = libevwrapper.IO(reader.fileno(), libevwrapper.EV_READ, loop, handle_read)
+
+    def ping_pong():
+        received[0] = 0
+        watcher.start()
+        writer.send(b'x')
+        loop.start()
+        return received[0]
+
+    return [Benchmark('libev[ping-pong]', 'events', events, None, ping_pong)]
+
+
+class BufferConnection(Connection):
+    """
+    A connection without a socket; responses are written straight to its
+    buffer.
+    """
+
+    _total_reqd_bytes = 0
+
+    def __init__(self, protocol_version, decompressor):
+        Connection.__init__(self, protocol_version=protocol_version, user_type_map={})
+        self.decompressor = decompressor
+        self._callbacks = {}
+
+
+def count_rows(protocol_version, frames, decompress=None):
+    conn = BufferConnection(protocol_version, decompress)
+    responses = []
+    conn._callbacks = dict((stream_id, responses.append) for stream_id in range(len(frames)))
+    conn._iobuf.write(b''.join(frames))
+    conn.process_io_buffer()
+
+    if len(responses) != len(frames) or not all(isinstance(r, ResultMessage) for r in responses):
+        raise Exception("Failed to decode corpus: %r" % (responses[:1],))
+    return sum(len(r.results[1]) for r in responses if r.kind == RESULT_KIND_ROWS)
+
+
+def process_io_buffer_benchmarks(corpus):
+    benchmarks = []
+    variants = [(None, None)] + [(name, compressor) for name, compressor in locally_supported_compressions.items()]
+    for corpus_name, (protocol_version, frames) in corpus.items():
+        for compression, compressor in variants:
+            name = corpus_name
+            stream = frames
+            decompress = None
+            if compression:
+                compress, decompress = compressor
+                stream = compress_frames(protocol_version, frames, compress)
+                name += '+' + compression
+
+            rows = count_rows(protocol_version, stream, decompress)
+            data = b''.join(stream)
+            chunks = [data[i:i + CHUNK_SIZE] for i in range(0, len(data), CHUNK_SIZE)]
+            conn = BufferConnection(protocol_version, decompress)
+
+            def process(conn=conn, chunks=chunks, stream_ids=range(len(frames))):
+                responses = []
+                conn._callbacks = dict.fromkeys(stream_ids, responses.append)
+                conn.request_ids.clear()
+                for chunk in chunks:
+                    conn._iobuf.write(chunk)
+                    conn.process_io_buffer()
+                return responses
+
+            benchmarks.append(Benchmark('process_io_buffer[%s]' % name, 'frames', len(frames),
+                                        rows or None, process))
+    return benchmarks
+
+
+def recv_results_rows_benchmarks(corpus):
+    benchmarks = []
+    for corpus_name, (protocol_version, frames) in corpus.items():
+        header_length = (5 if protocol_version >= 3 else 4) + 4
+        # skip the result kind
+        bodies = [frame[header_length + 4:] for frame in frames
+                  if int32_unpack(frame[header_length:header_length + 4]) == RESULT_KIND_ROWS]
+        if not bodies:
+            continue
+
+        def recv(bodies=bodies, protocol_version=protocol_version):
+            return [ResultMessage.recv_results_rows(io.BytesIO(body), protocol_version, {})
+                    for body in bodies]
+
+        rows = sum(len(results[1]) for _, results in recv())
+        benchmarks.append(Benchmark('recv_results_rows[%s]' % corpus_name, 'rows', rows, rows, recv))
+    return benchmarks
+
+
+def bind_benchmarks():
+    rng = random.Random(CORPUS_SEED)
+    benchmarks = []
+    for name, columns in (('text', TEXT_COLUMNS), ('mixed', MIXED_COLUMNS), ('collections', COLLECTION_COLUMNS)):
+        column_metadata = [('bench', 'table', column, typ) for column, typ in columns]
+        query = 'INSERT INTO bench.table (%s) VALUES (%s)' % (
+            ', '.join(column for column, _ in columns), ', '.join('?' * len(columns)))
+        prepared = PreparedStatement(column_metadata, b'\x00' * 16, [0], query, 'bench', 3)
+        values = [make_value(rng, typ) for _, typ in columns]
+        benchmarks.append(Benchmark('bind[%s]' % name, 'binds', 1, None,
+                                    lambda prepared=prepared, values=values: prepared.bind(values)))
+
+        named_values = dict((column, value) for (column, _), value in zip(columns, values))
+        benchmarks.append(Benchmark('bind[%s,dict]' % name, 'binds', 1, None,
+                                    lambda prepared=prepared, values=named_values: prepared.bind(values)))
+    return benchmarks
+
+
+def collect_benchmarks(corpus):
+    return (murmur3_benchmarks() + libev_benchmarks() + process_io_buffer_benchmarks(corpus) +
+            recv_results_rows_benchmarks(corpus) + bind_benchmarks())
+
+
+def time_calls(func, min_time, repeat):
+    """
+    Returns the time per call of each of `repeat` batches, with the batch
+    size chosen so that a batch takes at least `min_time` seconds.
+    """
+    timer = timeit.Timer(func)
+    number = 1
+    while True:
+        elapsed = timer.timeit(number)
+        if elapsed >= min_time:
+            break
+        number = max(number * 2, int(number * min_time / max(elapsed, 1e-9) * 1.1))
+    times = [elapsed] + timer.repeat(repeat - 1, number)
+    return [t / number for t in times]
+
+
+def count_allocations(func):
+    """
+    Returns the peak number of bytes allocated while calling `func`
+    (:const:`None` without :mod:`tracemalloc`) and the number of memory
+    blocks still allocated afterwards while its result is held
+    (:const:`None` without ``sys.getallocatedblocks()``).
+    """
+    gc.collect()
+    gc.disable()
+    try:
+        blocks = None
+        if hasattr(sys, 'getallocatedblocks'):
+            start = sys.getallocatedblocks()
+            result = func()
+            blocks = sys.getallocatedblocks() - start
+            del result
+
+        peak = None
+        if tracemalloc and not tracemalloc.is_tracing():
+            tracemalloc.start()
+            try:
+                start = tracemalloc.get_traced_memory()[0]
+                result = func()
+                peak = tracemalloc.get_traced_memory()[1] - start
+                del result
+            finally:
+                tracemalloc.stop()
+    finally:
+        gc.enable()
+    return peak, blocks
+
+
+def run_benchmark(benchmark, min_time, repeat):
+    times = time_calls(benchmark.func, min_time, repeat)
+    best = min(times)
+    peak, blocks = count_allocations(benchmark.func)
+    return OrderedDict([
+        ('unit', benchmark.unit + '/sec'),
+        ('ops_per_sec', benchmark.ops_per_call / best),
+        ('rows_per_sec', benchmark.rows_per_call / best if benchmark.rows_per_call else None),
+        ('ops_per_call', benchmark.ops_per_call),
+        ('seconds_per_call', times),
+        ('bytes_per_op', peak / float(benchmark.ops_per_call) if peak is not None else None),
+        ('blocks_per_op', blocks / float(benchmark.ops_per_call) if blocks is not None else None),
+    ])
+
+
+def _format_number(value, fmt='%.1f'):
+    return '-' if value is None else fmt % value
+
+
+def _format_rate(value):
+    if value is None:
+        return '-'
+    for divisor, suffix in ((1e6, 'M'), (1e3, 'k')):
+        if value >= divisor:
+            return '%.2f%s' % (value / divisor, suffix)
+    return '%.1f' % value
+
+
+def print_results(results):
+    print("%-40s %14s %10s %10s %12s %12s" % ("benchmark", "rate", "unit", "rows/sec", "bytes/op", "blocks/op"))
+    for name, result in results.items():
+        print("%-40s %14s %10s %10s %12s %12s" % (
+            name, _format_rate(result['ops_per_sec']), result['unit'], _format_rate(result['rows_per_sec']),
+            _format_number(result['bytes_per_op']), _format_number(result['blocks_per_op'], '%.2f')))
+
+
+def environment():
+    return OrderedDict([
+        ('python', sys.version.split()[0]),
+        ('implementation', platform.python_implementation()),
+        ('platform', platform.platform()),
+        ('cassandra', os.path.dirname(os.path.abspath(cassandra.__file__))),
+        ('driver_version', cassandra.__version__),
+        ('extensions', OrderedDict([('murmur3', murmur3 is not None), ('libev', libevwrapper is not None)])),
+        ('compressions', list(locally_supported_compressions)),
+    ])
+
+
+def _change(base, new):
+    if base is None or new is None or not base:
+        return None
+    return (new - base) * 100.0 / base
+
+
+def compare(base_path, new_path, threshold):
+    with open(base_path) as f:
+        base = json.load(f, object_pairs_hook=OrderedDict)
+    with open(new_path) as f:
+        new = json.load(f, object_pairs_hook=OrderedDict)
+
+    for key, value in base['environment'].items():
+        if new['environment'].get(key) != value:
+            print("%s: %s -> %s" % (key, json.dumps(value), json.dumps(new['environment'].get(key))))
+
+    print("%-40s %10s %10s %9s %12s %12s  %s" % (
+        "benchmark", "base", "new", "change", "bytes/op", "blocks/op", ""))
+    names = list(base['results']) + [name for name in new['results'] if name not in base['results']]
+    for name in names:
+        b = base['results'].get(name)
+        n = new['results'].get(name)
+        if b is None or n is None:
+            print("%-40s %10s %10s" % (name, _format_rate(b and b['ops_per_sec']), _format_rate(n and n['ops_per_sec'])))
+            continue
+
+        change = _change(b['ops_per_sec'], n['ops_per_sec'])
+        if change >= threshold:
+            verdict = 'faster'
+        elif change <= -threshold:
+            verdict = 'SLOWER'
+        else:
+            verdict = ''
+        bytes_change = _change(b['bytes_per_op'], n['bytes_per_op'])
+        blocks_change = _change(b.get('blocks_per_op'), n.get('blocks_per_op'))
+        print("%-40s %10s %10s %+8.1f%% %12s %12s  %s" % (
+            name, _format_rate(b['ops_per_sec']), _format_rate(n['ops_per_sec']), change,
+            _format_number(bytes_change, '%+.1f%%'), _format_number(blocks_change, '%+.1f%%'), verdict))
+
+
+def parse_options():
+    parser = OptionParser(usage="%prog [options]\n       %prog --compare BASE.json NEW.json")
+    parser.add_option('-b', '--benchmark', action='append', dest='benchmarks', default=[],
+                      help='only run benchmarks whose name contains this (can be repeated)')
+    parser.add_option('--list', action='store_true',
+                      help='list the benchmarks and exit')
+    parser.add_option('-r', '--repeat', type='int', default=5,
+                      help='number of timed batches per benchmark; the best is reported [default: %default]')
+    parser.add_option('--min-time', type='float', default=0.2, dest='min_time',
+                      help='minimum duration of a timed batch in seconds [default: %default]')
+    parser.add_option('-o', '--output',
+                      help='write the results as JSON to this file')
+    parser.add_option('--compare', nargs=2, metavar='BASE NEW',
+                      help='compare two JSON result files instead of running the benchmarks')
+    parser.add_option('--threshold', type='float', default=5.0,
+                      help='--compare: change in percent reported as faster or slower [default: %default]')
+    parser.add_option('--corpus', default=CORPUS_DIR,
+                      help='directory of the frame corpus [default: %default]')
+    parser.add_option('--write-corpus', action='store_true', dest='write_corpus',
+                      help='generate the frame corpus into --corpus and exit')
+    parser.add_option('-l', '--log-level', default='info',
+                      help='logging level: debug, info, warning, or error')
+    options, args = parser.parse_args()
+    log.setLevel(options.log_level.upper())
+    return options, args
+
+
+def main():
+    options, args = parse_options()
+
+    if options.compare:
+        compare(options.compare[0], options.compare[1], options.threshold)
+        return
+
+    if options.write_corpus:
+        write_corpus(options.corpus)
+        return
+
+    log.info("Using 'cassandra' package from %s", cassandra.__path__)
+    interpreter = "%s %s" % (platform.python_implementation(), platform.python_version())
+    if tracemalloc is None:
+        log.warning("tracemalloc is not available on %s; bytes/op will not be reported", interpreter)
+    if not hasattr(sys, 'getallocatedblocks'):
+        log.warning("sys.getallocatedblocks() is not available on %s; blocks/op will not be reported", interpreter)
+    if not locally_supported_compressions:
+        log.warning("No compression library (lz4 or python-snappy) is installed; "
+                    "process_io_buffer will only be benchmarked on uncompressed frames")
+    benchmarks = collect_benchmarks(load_corpus(options.corpus))
+    if options.benchmarks:
+        benchmarks = [b for b in benchmarks if any(pattern in b.name for pattern in options.benchmarks)]
+
+    if options.list:
+        for benchmark in benchmarks:
+            print(benchmark.name)
+        return
+
+    results = OrderedDict()
+    for benchmark in benchmarks:
+        log.debug("Running %s", benchmark.name)
+        results[benchmark.name] = run_benchmark(benchmark, options.min_time, options.repeat)
+
+    print_results(results)
+
+    if options.output:
+        with open(options.output, 'w') as f:
+            json.dump(OrderedDict([('environment', environment()),
+                                   ('min_time', options.min_time),
+                                   ('repeat', options.repeat),
+                                   ('results', results)]), f, indent=2)
+        log.info("Wrote results to %s", options.output)
+
+
+if __name__ == "__main__":
+    main()
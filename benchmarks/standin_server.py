@@ -0,0 +1,562 @@
+# Copyright 2013-2015 DataStax, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+A single-node stand-in for Cassandra that speaks enough of native protocol
+v1-v3 to drive the benchmarks without a real cluster.
+
+It answers OPTIONS, STARTUP and REGISTER, serves a one-node ``system.local``
+and an empty ``system.peers`` and schema, and replies to QUERY, PREPARE,
+EXECUTE and BATCH with canned results: ``SELECT`` statements get pages of
+identical rows, ``USE`` switches keyspace and everything else is a void
+result.  Responses can be delayed and a fraction of them replaced with
+errors; both are driven by a seeded random generator, so a run is
+reproducible.
+
+Run it on its own::
+
+    python benchmarks/standin_server.py --port 9042 --latency-ms 0.5
+
+or pass ``--stand-in`` to any benchmark to start one for the run.
+"""
+
+from collections import deque
+import errno
+import hashlib
+import heapq
+import io
+import logging
+from optparse import OptionParser
+import os
+import random
+import select
+import socket
+import sys
+import time
+import uuid
+
+dirname = os.path.dirname(os.path.abspath(__file__))
+sys.path.append(os.path.join(dirname, '..'))
+
+from cassandra.cqltypes import SetType, UTF8Type, UUIDType
+from cassandra.marshal import header_pack, v3_header_pack, header_unpack, v3_header_unpack, int32_pack, int32_unpack
+from cassandra.protocol import (HEADER_DIRECTION_TO_CLIENT, write_byte, write_int, write_short,
+                                write_string, write_stringmultimap, write_value, read_binary_string,
+                                read_byte, read_int, read_longstring, read_short, read_value)
+
+log = logging.getLogger(__name__)
+
+MIN_PROTOCOL_VERSION = 1
+MAX_PROTOCOL_VERSION = 3
+
+# request opcodes
+_STARTUP = 0x01
+_OPTIONS = 0x05
+_QUERY = 0x07
+_PREPARE = 0x09
+_EXECUTE = 0x0A
+_REGISTER = 0x0B
+_BATCH = 0x0D
+
+# response opcodes
+_ERROR = 0x00
+_READY = 0x02
+_SUPPORTED = 0x06
+_RESULT = 0x08
+
+_RESULT_VOID = 0x0001
+_RESULT_ROWS = 0x0002
+_RESULT_SET_KEYSPACE = 0x0003
+_RESULT_PREPARED = 0x0004
+
+_GLOBAL_TABLES_SPEC = 0x0001
+_HAS_MORE_PAGES = 0x0002
+_NO_METADATA = 0x0004
+
+_VALUES_FLAG = 0x01
+_PAGE_SIZE_FLAG = 0x04
+_WITH_PAGING_STATE_FLAG = 0x08
+
+_VARCHAR = (0x000D,)
+_BOOLEAN = (0x0004,)
+_UUID = (0x000C,)
+_SET_OF_VARCHAR = (0x0022, 0x000D)
+
+CLUSTER_NAME = 'Stand-in Cluster'
+SCHEMA_VERSION = uuid.UUID('5d9ee7ee-4b8d-4f0e-b8f0-7ef0e1b8b4c6')
+
+_LOCAL_COLUMNS = (('key', _VARCHAR), ('cluster_name', _VARCHAR), ('data_center', _VARCHAR),
+                  ('rack', _VARCHAR), ('partitioner', _VARCHAR), ('release_version', _VARCHAR),
+                  ('schema_version', _UUID), ('tokens', _SET_OF_VARCHAR))
+
+_PEERS_COLUMNS = (('peer', _VARCHAR), ('data_center', _VARCHAR), ('rack', _VARCHAR),
+                  ('rpc_address', _VARCHAR), ('schema_version', _UUID), ('tokens', _SET_OF_VARCHAR))
+
+_KEYSPACES_COLUMNS = (('keyspace_name', _VARCHAR), ('durable_writes', _BOOLEAN),
+                      ('strategy_class', _VARCHAR), ('strategy_options', _VARCHAR))
+
+# the shape of the table the benchmarks write to
+_CANNED_COLUMNS = (('thekey', _VARCHAR), ('col1', _VARCHAR), ('col2', _VARCHAR))
+
+ERRORS = {
+    'server_error': 0x0000,
+    'unavailable': 0x1000,
+    'overloaded': 0x1001,
+    'write_timeout': 0x1100,
+    'read_timeout': 0x1200,
+}
+
+_UNPREPARED = 0x2500
+_PROTOCOL_ERROR = 0x000A
+
+
+class StandInServer(object):
+    """
+    Serves canned responses on `port` (0 picks a free port; see
+    :attr:`port` once constructed) until :meth:`serve_forever()` is
+    interrupted.
+
+    `rows` is the number of rows returned for a ``SELECT`` (split into
+    pages if the client asks for them), `latency_ms` and `jitter_ms` delay
+    each response by ``latency_ms + uniform(0, jitter_ms)`` milliseconds,
+    and `error_rate` is the fraction of QUERY, EXECUTE and BATCH requests
+    answered with the error named by `error` (a key of :data:`ERRORS`).
+    """
+
+    def __init__(self, host='127.0.0.1', port=9042, rows=10, latency_ms=0.0, jitter_ms=0.0,
+                 error_rate=0.0, error='unavailable', seed=0):
+        if error not in ERRORS:
+            raise ValueError("Unknown error %r; expected one of %s" % (error, ', '.join(sorted(ERRORS))))
+
+        self.rows = rows
+        self.latency = latency_ms / 1000.0
+        self.jitter = jitter_ms / 1000.0
+        self.error_rate = error_rate
+        self.error_code = ERRORS[error]
+        self._random = random.Random(seed)
+
+        self._listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self._listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self._listener.bind((host, port))
+        self._listener.listen(128)
+        self._listener.setblocking(0)
+        self.host, self.port = self._listener.getsockname()
+
+        self._clients = {}
+        self._delayed = []
+        self._delayed_seq = 0
+        self._prepared = {}
+        self._row_bytes = [_encode_values([('key%d' % i).encode('utf-8'), b'a', b'b']) for i in range(rows)]
+        self.request_count = 0
+
+    def serve_forever(self):
+        log.info("Stand-in server listening on %s:%d", self.host, self.port)
+        try:
+            while True:
+                self._poll()
+        finally:
+            self.close()
+
+    def close(self):
+        for client in list(self._clients.values()):
+            client.close()
+        self._clients.clear()
+        self._listener.close()
+
+    def _poll(self):
+        timeout = None
+        if self._delayed:
+            timeout = max(0.0, self._delayed[0][0] - time.time())
+
+        readers = [self._listener] + list(self._clients.values())
+        writers = [c for c in self._clients.values() if c.out]
+        readable, writable, _ = select.select(readers, writers, [], timeout)
+
+        for sock in readable:
+            if sock is self._listener:
+                self._accept()
+            else:
+                sock.handle_read(self)
+        for client in writable:
+            client.handle_write()
+
+        now = time.time()
+        while self._delayed and self._delayed[0][0] <= now:
+            _, _, client, data = heapq.heappop(self._delayed)
+            # file descriptors are reused, so make sure it is the same client
+            if self._clients.get(client.fileno()) is client:
+                client.send(data)
+
+    def _accept(self):
+        try:
+            sock, _ = self._listener.accept()
+        except socket.error as exc:
+            if exc.args[0] in (errno.EAGAIN, errno.EWOULDBLOCK):
+                return
+            raise
+        client = _Client(sock)
+        self._clients[client.fileno()] = client
+
+    def _drop(self, client):
+        self._clients.pop(client.fileno(), None)
+        client.close()
+
+    def handle_request(self, client, version, stream_id, opcode, body):
+        self.request_count += 1
+        f = io.BytesIO(body)
+        delay = True
+
+        if opcode == _OPTIONS:
+            response = self._supported()
+            delay = False
+        elif opcode in (_STARTUP, _REGISTER):
+            response = _READY, b''
+            delay = False
+        elif opcode == _QUERY:
+            query = read_longstring(f)
+            page_size, paging_state = _read_query_parameters(f, version)
+            response = self._maybe_error(query) or self._query_result(client, query, version, page_size, paging_state)
+            delay = not _is_system_query(query)
+        elif opcode == _PREPARE:
+            query = read_longstring(f)
+            response = self._prepared_result(query, version)
+        elif opcode == _EXECUTE:
+            query_id = read_binary_string(f)
+            query = self._prepared.get(query_id)
+            if query is None:
+                response = _error(_UNPREPARED, "Prepared query with ID %s not found" % (query_id,), query_id)
+            else:
+                if version == 1:
+                    _read_values(f)
+                    page_size, paging_state = None, None
+                else:
+                    page_size, paging_state = _read_query_parameters(f, version)
+                response = self._maybe_error(query) or self._query_result(client, query, version, page_size, paging_state)
+        elif opcode == _BATCH:
+            response = self._maybe_error('BATCH') or (_RESULT, int32_pack(_RESULT_VOID))
+        else:
+            response = _error(_PROTOCOL_ERROR, "Unsupported opcode 0x%02x" % (opcode,))
+
+        data = _frame(version, stream_id, *response)
+        wait = self.latency + (self._random.random() * self.jitter if self.jitter else 0.0) if delay else 0.0
+        if wait > 0:
+            self._delayed_seq += 1
+            heapq.heappush(self._delayed, (time.time() + wait, self._delayed_seq, client, data))
+        else:
+            client.send(data)
+
+    def _supported(self):
+        f = io.BytesIO()
+        write_stringmultimap(f, {'CQL_VERSION': ['3.2.0'], 'COMPRESSION': []})
+        return _SUPPORTED, f.getvalue()
+
+    def _maybe_error(self, query):
+        if self.error_rate and not _is_system_query(query) and self._random.random() < self.error_rate:
+            return _error(self.error_code, "Injected error")
+        return None
+
+    def _query_result(self, client, query, version, page_size, paging_state):
+        words = query.strip().split(None, 2)
+        verb = words[0].lower() if words else ''
+        if verb == 'use':
+            keyspace = words[1].strip('";')
+            client.keyspace = keyspace
+            f = io.BytesIO()
+            write_int(f, _RESULT_SET_KEYSPACE)
+            write_string(f, keyspace)
+            return _RESULT, f.getvalue()
+        elif verb != 'select':
+            return _RESULT, int32_pack(_RESULT_VOID)
+
+        lowered = query.lower()
+        if 'system.local' in lowered:
+            row = _encode_values([b'local', CLUSTER_NAME.encode('utf-8'), b'dc1', b'rack1',
+                                  b'org.apache.cassandra.dht.Murmur3Partitioner', b'2.1.5',
+                                  UUIDType.to_binary(SCHEMA_VERSION, version),
+                                  SetType.apply_parameters([UTF8Type]).to_binary(['0'], version)])
+            return _RESULT, _rows('system', 'local', _LOCAL_COLUMNS, [row])
+        elif 'system.peers' in lowered:
+            return _RESULT, _rows('system', 'peers', _PEERS_COLUMNS, [])
+        elif 'system.schema_keyspaces' in lowered:
+            row = _encode_values([b'system', b'\x01', b'org.apache.cassandra.locator.LocalStrategy', b'{}'])
+            return _RESULT, _rows('system', 'schema_keyspaces', _KEYSPACES_COLUMNS, [row])
+        elif 'system.' in lowered:
+            # empty schema tables
+            return _RESULT, _rows('system', 'schema', (), [])
+
+        start = 0
+        if paging_state:
+            start = int32_unpack(paging_state)
+        end = self.rows
+        next_paging_state = None
+        if page_size and page_size > 0 and start + page_size < self.rows:
+            end = start + page_size
+            next_paging_state = int32_pack(end)
+        return _RESULT, _rows(client.keyspace or 'benchmarks', 'canned', _CANNED_COLUMNS,
+                              self._row_bytes[start:end], next_paging_state)
+
+    def _prepared_result(self, query, version):
+        query_id = hashlib.md5(query.encode('utf-8')).digest()
+        self._prepared[query_id] = query
+
+        f = io.BytesIO()
+        write_int(f, _RESULT_PREPARED)
+        write_short(f, len(query_id))
+        f.write(query_id)
+        _write_metadata(f, 'benchmarks', 'canned', _bind_columns(query))
+        if version >= 2:
+            if query.strip().lower().startswith('select'):
+                _write_metadata(f, 'benchmarks', 'canned', _CANNED_COLUMNS)
+            else:
+                write_int(f, _NO_METADATA)
+                write_int(f, 0)
+        return _RESULT, f.getvalue()
+
+
+class _Client(object):
+
+    keyspace = None
+
+    def __init__(self, sock):
+        sock.setblocking(0)
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.sock = sock
+        self._fileno = sock.fileno()
+        self.buf = b''
+        self.out = deque()
+
+    def fileno(self):
+        return self._fileno
+
+    def close(self):
+        self.sock.close()
+
+    def send(self, data):
+        if not self.out:
+            try:
+                sent = self.sock.send(data)
+            except socket.error as exc:
+                if exc.args[0] not in (errno.EAGAIN, errno.EWOULDBLOCK):
+                    return
+                sent = 0
+            data = data[sent:]
+            if not data:
+                return
+        self.out.append(data)
+
+    def handle_write(self):
+        while self.out:
+            data = self.out.popleft()
+            try:
+                sent = self.sock.send(data)
+            except socket.error as exc:
+                if exc.args[0] not in (errno.EAGAIN, errno.EWOULDBLOCK):
+                    self.out.clear()
+                    return
+                sent = 0
+            if sent < len(data):
+                self.out.appendleft(data[sent:])
+                return
+
+    def handle_read(self, server):
+        try:
+            data = self.sock.recv(65536)
+        except socket.error as exc:
+            if exc.args[0] in (errno.EAGAIN, errno.EWOULDBLOCK):
+                return
+            data = b''
+        if not data:
+            server._drop(self)
+            return
+
+        buf = self.buf + data
+        pos = 0
+        while len(buf) - pos >= 8:
+            version = bytearray(buf[pos:pos + 1])[0] & 0x7f
+            if version >= 3:
+                header_size = 9
+                if len(buf) - pos < header_size:
+                    break
+                _, flags, stream_id, opcode = v3_header_unpack(buf[pos:pos + 5])
+            else:
+                header_size = 8
+                _, flags, stream_id, opcode = header_unpack(buf[pos:pos + 4])
+            body_len = int32_unpack(buf[pos + header_size - 4:pos + header_size])
+            if len(buf) - pos < header_size + body_len:
+                break
+            body = buf[pos + header_size:pos + header_size + body_len]
+            pos += header_size + body_len
+
+            if not MIN_PROTOCOL_VERSION <= version <= MAX_PROTOCOL_VERSION:
+                message = "Invalid or unsupported protocol version: %d" % (version,)
+                self.send(_frame(min(version, MAX_PROTOCOL_VERSION), stream_id, *_error(_PROTOCOL_ERROR, message)))
+                continue
+            server.handle_request(self, version, stream_id, opcode, body)
+        self.buf = buf[pos:]
+
+
+def _is_system_query(query):
+    return 'system.' in query.lower()
+
+
+def _frame(version, stream_id, opcode, body):
+    pack = v3_header_pack if version >= 3 else header_pack
+    return pack(version | HEADER_DIRECTION_TO_CLIENT, 0, stream_id, opcode) + int32_pack(len(body)) + body
+
+
+def _error(code, message, query_id=None):
+    f = io.BytesIO()
+    write_int(f, code)
+    write_string(f, message)
+    if code == _UNPREPARED:
+        write_short(f, len(query_id))
+        f.write(query_id)
+    elif code == ERRORS['unavailable']:
+        write_short(f, 1)  # consistency
+        write_int(f, 1)  # required
+        write_int(f, 0)  # alive
+    elif code == ERRORS['write_timeout']:
+        write_short(f, 1)
+        write_int(f, 0)  # received
+        write_int(f, 1)  # block for
+        write_string(f, 'SIMPLE')
+    elif code == ERRORS['read_timeout']:
+        write_short(f, 1)
+        write_int(f, 0)
+        write_int(f, 1)
+        write_byte(f, 0)  # data present
+    return _ERROR, f.getvalue()
+
+
+def _encode_values(values):
+    f = io.BytesIO()
+    for value in values:
+        write_value(f, value)
+    return f.getvalue()
+
+
+def _write_metadata(f, keyspace, table, columns, paging_state=None):
+    flags = _GLOBAL_TABLES_SPEC
+    if paging_state:
+        flags |= _HAS_MORE_PAGES
+    write_int(f, flags)
+    write_int(f, len(columns))
+    if paging_state:
+        write_value(f, paging_state)
+    write_string(f, keyspace)
+    write_string(f, table)
+    for name, type_codes in columns:
+        write_string(f, name)
+        for code in type_codes:
+            write_short(f, code)
+
+
+def _rows(keyspace, table, columns, rows, paging_state=None):
+    f = io.BytesIO()
+    write_int(f, _RESULT_ROWS)
+    _write_metadata(f, keyspace, table, columns, paging_state)
+    write_int(f, len(rows))
+    for row in rows:
+        f.write(row)
+    return f.getvalue()
+
+
+def _bind_columns(query):
+    """
+    All bind markers are typed as varchar, named after the INSERT column
+    list when there is one.
+    """
+    markers = query.count('?')
+    names = []
+    lowered = query.lower()
+    if lowered.strip().startswith('insert') and '(' in query:
+        names = [n.strip().strip('"') for n in query[query.index('(') + 1:query.index(')')].split(',')]
+    if len(names) != markers:
+        names = ['col%d' % i for i in range(markers)]
+    return tuple((name, _VARCHAR) for name in names)
+
+
+def _read_values(f):
+    return [read_value(f) for _ in range(read_short(f))]
+
+
+def _read_query_parameters(f, version):
+    """ Returns the page size and paging state of a QUERY or EXECUTE. """
+    read_short(f)  # consistency
+    if version == 1:
+        return None, None
+
+    flags = read_byte(f)
+    if flags & _VALUES_FLAG:
+        _read_values(f)
+    page_size = read_int(f) if flags & _PAGE_SIZE_FLAG else None
+    paging_state = read_value(f) if flags & _WITH_PAGING_STATE_FLAG else None
+    return page_size, paging_state
+
+
+def run_in_process(**kwargs):
+    """
+    Starts a :class:`StandInServer` with `kwargs` in a child process and
+    returns ``(process, port)``.  Unless given, the port is picked by the OS.
+    Terminate the process when done.
+    """
+    from multiprocessing import Process, Pipe
+
+    kwargs.setdefault('port', 0)
+    parent_conn, child_conn = Pipe()
+    process = Process(target=_serve, args=(child_conn, kwargs))
+    process.daemon = True
+    process.start()
+    return process, parent_conn.recv()
+
+
+def _serve(conn, kwargs):
+    server = StandInServer(**kwargs)
+    conn.send(server.port)
+    server.serve_forever()
+
+
+def parse_options():
+    parser = OptionParser()
+    parser.add_option('--host', default='127.0.0.1',
+                      help='address to listen on [default: %default]')
+    parser.add_option('--port', type='int', default=9042,
+                      help='port to listen on [default: %default]')
+    parser.add_option('--rows', type='int', default=10,
+                      help='rows returned for each SELECT [default: %default]')
+    parser.add_option('--latency-ms', type='float', default=0.0, dest='latency_ms',
+                      help='fixed delay added to each response [default: %default]')
+    parser.add_option('--jitter-ms', type='float', default=0.0, dest='jitter_ms',
+                      help='maximum random delay added on top of the fixed delay [default: %default]')
+    parser.add_option('--error-rate', type='float', default=0.0, dest='error_rate',
+                      help='fraction of requests answered with an error [default: %default]')
+    parser.add_option('--error', default='unavailable', choices=sorted(ERRORS),
+                      help='error to inject: %s [default: %%default]' % ', '.join(sorted(ERRORS)))
+    parser.add_option('--seed', type='int', default=0,
+                      help='seed for latency and error injection [default: %default]')
+    parser.add_option('-l', '--log-level', default='info',
+                      help='logging level: debug, info, warning, or error')
+    return parser.parse_args()
+
+
+if __name__ == "__main__":
+    options, _ = parse_options()
+    logging.basicConfig(level=options.log_level.upper(),
+                        format="%(asctime)s [%(levelname)s] %(name)s: %(message)s")
+    server = StandInServer(options.host, options.port, options.rows, options.latency_ms,
+                           options.jitter_ms, options.error_rate, options.error, options.seed)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
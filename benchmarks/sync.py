@@ -22,7 +22,7 @@ class Runner(BenchmarkThread):
         self.start_profile()
 
         for _ in range(self.num_queries):
-            self.session.execute(self.query, self.values)
+            self.execute()
 
         self.finish_profile()
 
@@ -111,6 +111,8 @@ DEFAULT_MAX_CONNECTIONS_PER_REMOTE_HOST = 2
 
 _NOT_SET = object()
 
+_PREPARED_CACHE_SAVE_DELAY = 1.0
+
 
 class NoHostAvailable(Exception):
     """
@@ -434,6 +436,34 @@ class Cluster(object):
     establishment, options passing, and authentication.
     """
 
+    metadata_snapshot = None
+    """
+    An optional :class:`~cassandra.snapshot.MetadataSnapshot` shared with
+    other processes, typically the workers of a pre-fork server.
+
+    In the process that created the snapshot, the token ring, replica maps,
+    schema rows and prepared statement ids are published to it whenever they
+    are refreshed.  In every other process, they are reused from it on
+    connect and on topology refreshes, as long as they still match the
+    topology and schema version reported by the control connection; otherwise
+    the metadata is fetched and built as usual.
+
+    .. versionadded:: 2.6.0
+    """
+
+    prepared_statement_cache = None
+    """
+    An optional :class:`~cassandra.preparedcache.PreparedStatementCache`.
+
+    Statements prepared through this cluster's sessions are saved to it in
+    the background and on :meth:`.shutdown()`.  After a restart,
+    :meth:`.Session.prepare()` returns statements from it without
+    contacting the cluster, as long as the cluster name and schema version
+    have not changed.
+
+    .. versionadded:: 2.6.0
+    """
+
     sessions = None
     control_connection = None
     scheduler = None
@@ -473,7 +503,9 @@ class Cluster(object):
                  idle_heartbeat_interval=30,
                  schema_event_refresh_window=2,
                  topology_event_refresh_window=10,
-                 connect_timeout=5):
+                 connect_timeout=5,
+                 metadata_snapshot=None,
+                 prepared_statement_cache=None):
         """
         Any of the mutable Cluster attributes may be set as keyword arguments
         to the constructor.
@@ -527,6 +559,8 @@ class Cluster(object):
         self.schema_event_refresh_window = schema_event_refresh_window
         self.topology_event_refresh_window = topology_event_refresh_window
         self.connect_timeout = connect_timeout
+        self.metadata_snapshot = metadata_snapshot
+        self.prepared_statement_cache = prepared_statement_cache
 
         self._listeners = set()
         self._listener_lock = Lock()
@@ -814,6 +848,8 @@ class Cluster(object):
 
         self.executor.shutdown()
 
+        self._save_prepared_statements()
+
     def _new_session(self):
         session = Session(self, self.metadata.all_hosts())
         for keyspace, type_map in six.iteritems(self._user_types):
@@ -1221,9 +1257,53 @@ class Cluster(object):
     def prepare_on_all_sessions(self, query_id, prepared_statement, excluded_host):
         with self._prepared_statement_lock:
             self._prepared_statements[query_id] = prepared_statement
+
+        snapshot = self.metadata_snapshot
+        if snapshot and not snapshot.is_publisher:
+            contents = self.control_connection.load_snapshot()
+            if contents and query_id in contents.prepared_statement_ids:
+                # the publishing process has already prepared this on every host
+                return
+
         for session in self.sessions:
             session.prepare_on_all_hosts(prepared_statement.query_string, excluded_host)
 
+        if snapshot and snapshot.is_publisher:
+            # only advertised once every host has it, so that workers can skip preparing it
+            with self._prepared_statement_lock:
+                snapshot.set_prepared_statements(list(self._prepared_statements.values()))
+            try:
+                snapshot.publish_prepared()
+            except Exception:
+                log.warning("Failed to publish prepared statements to metadata snapshot", exc_info=True)
+
+    def _add_cached_prepared_statement(self, query, keyspace, protocol_version):
+        cache = self.prepared_statement_cache
+        if cache is None:
+            return None
+
+        prepared_statement = cache.get(query, keyspace, protocol_version, self._user_types)
+        if prepared_statement:
+            with self._prepared_statement_lock:
+                self._prepared_statements[prepared_statement.query_id] = prepared_statement
+        return prepared_statement
+
+    def _cache_prepared_statement(self, prepared_statement, cluster_name, schema_version):
+        cache = self.prepared_statement_cache
+        if cache is not None and cache.add(prepared_statement, cluster_name, schema_version):
+            # coalesces the writes for statements prepared together, such as at startup
+            self.scheduler.schedule_unique(_PREPARED_CACHE_SAVE_DELAY, self._save_prepared_statements)
+
+    def _save_prepared_statements(self):
+        cache = self.prepared_statement_cache
+        if cache is None:
+            return
+
+        try:
+            cache.save()
+        except Exception:
+            log.warning("Failed to save prepared statement cache", exc_info=True)
+
 
 class Session(object):
     """
@@ -1541,7 +1621,21 @@ class Session(object):
 
         **Important**: PreparedStatements should be prepared only once.
         Preparing the same query more than once will likely affect performance.
+
+        If the cluster has a :attr:`~.Cluster.prepared_statement_cache`
+        holding this query, the statement is returned from it without
+        contacting the cluster.
         """
+        prepared_statement = self.cluster._add_cached_prepared_statement(
+            query, self.keyspace, self._protocol_version)
+        if prepared_statement:
+            return prepared_statement
+
+        cache = self.cluster.prepared_statement_cache
+        if cache is not None:
+            # the bind metadata is only cached if the schema is still at this version
+            cluster_name, schema_version = cache.cluster_name, cache.schema_version
+
         message = PrepareMessage(query=query)
         future = ResponseFuture(self, message, query=None)
         try:
@@ -1555,6 +1649,9 @@ class Session(object):
             query_id, column_metadata, self.cluster.metadata, query, self.keyspace,
             self._protocol_version)
 
+        if cache is not None:
+            self.cluster._cache_prepared_statement(prepared_statement, cluster_name, schema_version)
+
         host = future._current_host
         try:
             self.cluster.prepare_on_all_sessions(query_id, prepared_statement, host)
@@ -2049,6 +2146,14 @@ class ControlConnection(object):
             log.debug("Skipping schema refresh due to lack of schema agreement")
             return False
 
+        snapshot = self._cluster.metadata_snapshot
+        cache = self._cluster.prepared_statement_cache
+        schema_version = None
+        if cache is not None or (snapshot and not keyspace):
+            schema_version = self._get_schema_version(connection, preloaded_results)
+        if cache is not None and schema_version:
+            cache.set_schema_version(self._cluster.metadata.cluster_name, schema_version)
+
         cl = ConsistencyLevel.ONE
         if table:
             def _handle_results(success, result):
@@ -2093,6 +2198,15 @@ class ControlConnection(object):
             ks_result = dict_factory(*ks_result.results) if ks_result.results else {}
             self._cluster.metadata.keyspace_changed(keyspace, ks_result)
         else:
+            if snapshot and not snapshot.is_publisher:
+                contents = self.load_snapshot()
+                if contents and contents.schema_rows and schema_version and \
+                        contents.schema_version == schema_version:
+                    log.debug("[control connection] Rebuilding schema from metadata snapshot generation %d",
+                              contents.generation)
+                    self._cluster.metadata.rebuild_schema(*contents.schema_rows)
+                    return True
+
             # build everything from scratch
             queries = [
                 QueryMessage(query=self._SELECT_KEYSPACES, consistency_level=cl),
@@ -2148,8 +2262,49 @@ class ControlConnection(object):
 
             log.debug("[control connection] Fetched schema, rebuilding metadata")
             self._cluster.metadata.rebuild_schema(ks_result, types_result, cf_result, col_result, triggers_result)
+
+            if snapshot and snapshot.is_publisher:
+                snapshot.set_schema_rows(schema_version, (ks_result, types_result, cf_result, col_result, triggers_result))
+                # targeted refreshes leave the snapshot at the last full
+                # refresh; publishing costs time proportional to the schema
+                self.publish_snapshot()
+
         return True
 
+    def _get_schema_version(self, connection, preloaded_results=None):
+        if preloaded_results:
+            local_result = preloaded_results[1]
+        else:
+            local_query = QueryMessage(query=self._SELECT_SCHEMA_LOCAL, consistency_level=ConsistencyLevel.ONE)
+            local_result = connection.wait_for_response(local_query, timeout=self._timeout)
+
+        if local_result.results:
+            return dict_factory(*local_result.results)[0].get("schema_version")
+        return None
+
+    def load_snapshot(self):
+        """
+        Returns the current contents of the cluster's metadata snapshot, or
+        :const:`None` if there is no usable snapshot.
+        """
+        snapshot = self._cluster.metadata_snapshot
+        if not snapshot:
+            return None
+        try:
+            return snapshot.load()
+        except Exception:
+            log.warning("[control connection] Failed to read metadata snapshot", exc_info=True)
+            return None
+
+    def publish_snapshot(self):
+        snapshot = self._cluster.metadata_snapshot
+        if not snapshot or not snapshot.is_publisher:
+            return
+        try:
+            snapshot.publish(self._cluster.metadata)
+        except Exception:
+            log.warning("[control connection] Failed to publish metadata snapshot", exc_info=True)
+
     def refresh_node_list_and_token_map(self, force_token_rebuild=False):
         if not self._meta_refresh_enabled:
             log.debug("[control connection] Skipping node list refresh because meta refresh is disabled")
@@ -2244,7 +2399,12 @@ class ControlConnection(object):
         log.debug("[control connection] Finished fetching ring info")
         if partitioner and should_rebuild_token_map:
             log.debug("[control connection] Rebuilding token map due to topology changes")
-            self._cluster.metadata.rebuild_token_map(partitioner, token_map)
+            snapshot = self._cluster.metadata_snapshot
+            if snapshot and not snapshot.is_publisher:
+                self._cluster.metadata.rebuild_token_map(partitioner, token_map, snapshot=self.load_snapshot())
+            else:
+                self._cluster.metadata.rebuild_token_map(partitioner, token_map, compute_digest=snapshot is not None)
+                self.publish_snapshot()
 
     def _update_location_info(self, host, datacenter, rack):
         if host.datacenter == datacenter and host.rack == rack:
@@ -2776,6 +2936,10 @@ class ResponseFuture(object):
                     else:
                         query_id = response.info
 
+                    cache = self.session.cluster.prepared_statement_cache
+                    if cache is not None:
+                        cache.discard(query_id)
+
                     try:
                         prepared_statement = self.session.cluster._prepared_statements[query_id]
                     except KeyError:
@@ -14,9 +14,11 @@
 
 from copy import deepcopy, copy
 from datetime import date, datetime
+import decimal
 import logging
 import re
 import six
+import uuid
 import warnings
 
 from cassandra.cqltypes import DateType
@@ -26,13 +28,18 @@ from cassandra.cqlengine import ValidationError
 
 log = logging.getLogger(__name__)
 
+# values of these types are never changed in place, so they
+# are not copied to keep track of the previous value
+_immutable_types = frozenset((type(None), bool, float, six.text_type, six.binary_type,
+                              decimal.Decimal, uuid.UUID, date, datetime) + six.integer_types)
+
 
 class BaseValueManager(object):
 
     def __init__(self, instance, column, value):
         self.instance = instance
         self.column = column
-        self.previous_value = deepcopy(value)
+        self.previous_value = value if type(value) in _immutable_types else deepcopy(value)
         self.value = value
         self.explicit = False
 
@@ -911,6 +918,23 @@ class UserDefinedType(Column):
         return list(self.user_type._fields.values())
 
 
+# to_python() implementations that return values deserialized by the driver
+# unchanged, so they can be skipped when loading query results
+_db_passthrough = frozenset(six.get_unbound_function(col.to_python) for col in
+                            (Column, Blob, Integer, VarInt, DateTime, UUID, Boolean, BaseFloat, Decimal))
+
+
+def db_value_converter(column):
+    """
+    Returns the function converting values of `column` read from the
+    database, or None if the driver already deserializes them to what
+    :meth:`~.Column.to_python` would return.
+    """
+    if six.get_unbound_function(type(column).to_python) in _db_passthrough:
+        return None
+    return column.to_python
+
+
 def resolve_udts(col_def, out_list):
     for col in col_def.sub_columns:
         resolve_udts(col, out_list)
@@ -354,6 +354,8 @@ class BaseModel(object):
     _if_not_exists = False  # optional if_not_exists flag to check existence before insertion
 
     def __init__(self, **values):
+        # instances loaded from query results skip this; keep
+        # _compile_row_constructor() in sync with it
         self._values = {}
         self._ttl = self.__default_ttl__
         self._timestamp = None
@@ -405,6 +407,33 @@ class BaseModel(object):
             raise ModelException('_get_model_by_discriminator_value can only be called on polymorphic base classes')
         return cls._discriminator_map.get(key)
 
+    @classmethod
+    def _get_polymorphic_class(cls, disc_key):
+        """
+        Returns the subclass of this polymorphic model with the
+        discriminator value `disc_key`
+        """
+        if disc_key is None:
+            raise PolymorphicModelException('discriminator value was not found in values')
+
+        poly_base = cls if cls._is_polymorphic_base else cls._polymorphic_base
+
+        klass = poly_base._get_model_by_discriminator_value(disc_key)
+        if klass is None:
+            poly_base._discover_polymorphic_submodels()
+            klass = poly_base._get_model_by_discriminator_value(disc_key)
+            if klass is None:
+                raise PolymorphicModelException(
+                    'unrecognized discriminator column {} for class {}'.format(disc_key, poly_base.__name__)
+                )
+
+        if not issubclass(klass, cls):
+            raise PolymorphicModelException(
+                '{} is not a subclass of {}'.format(klass.__name__, cls.__name__)
+            )
+
+        return klass
+
     @classmethod
     def _construct_instance(cls, values):
         """
@@ -418,29 +447,8 @@ class BaseModel(object):
         field_dict = dict([(cls._db_map.get(k, k), v) for k, v in items])
 
         if cls._is_polymorphic:
-            disc_key = field_dict.get(cls._discriminator_column_name)
-
-            if disc_key is None:
-                raise PolymorphicModelException('discriminator value was not found in values')
-
-            poly_base = cls if cls._is_polymorphic_base else cls._polymorphic_base
-
-            klass = poly_base._get_model_by_discriminator_value(disc_key)
-            if klass is None:
-                poly_base._discover_polymorphic_submodels()
-                klass = poly_base._get_model_by_discriminator_value(disc_key)
-                if klass is None:
-                    raise PolymorphicModelException(
-                        'unrecognized discriminator column {} for class {}'.format(disc_key, poly_base.__name__)
-                    )
-
-            if not issubclass(klass, cls):
-                raise PolymorphicModelException(
-                    '{} is not a subclass of {}'.format(klass.__name__, cls.__name__)
-                )
-
+            klass = cls._get_polymorphic_class(field_dict.get(cls._discriminator_column_name))
             field_dict = {k: v for k, v in field_dict.items() if k in klass._columns.keys()}
-
         else:
             klass = cls
 
@@ -448,6 +456,88 @@ class BaseModel(object):
         instance._is_persisted = True
         return instance
 
+    @classmethod
+    def _get_row_constructor(cls, fields=()):
+        """
+        Returns a function that builds instances from query result rows
+        selecting the database columns `fields`, or all columns if empty.
+        It gives the same instances as :meth:`_construct_instance`.
+        """
+        if not cls._is_polymorphic:
+            return cls._compile_row_constructor(fields)
+
+        disc_db_name = cls._discriminator_column.db_field_name
+
+        def construct(row):
+            klass = cls._get_polymorphic_class(row.get(disc_db_name))
+            return klass._compile_row_constructor(fields)(row)
+        return construct
+
+    @classmethod
+    def _compile_row_constructor(cls, fields=()):
+        """
+        Returns a function that builds instances of exactly this class from
+        rows selecting `fields`.  It is built once per set of fields: rows
+        go straight into value managers, without the keyword arguments
+        and checks of :meth:`__init__`, and values are only converted by
+        columns whose :meth:`~.Column.to_python` changes what the driver
+        deserialized.
+        """
+        fields = tuple(fields)
+        constructor = cls._row_constructors.get(fields)
+        if constructor is not None:
+            return constructor
+
+        if six.get_unbound_function(cls.__init__) is not six.get_unbound_function(BaseModel.__init__):
+            # custom constructors have to see every instance
+            constructor = cls._row_constructors[fields] = cls._construct_instance
+            return constructor
+
+        selected = set(fields)
+        loaded = []
+        unloaded = []
+        for name, column in cls._columns.items():
+            is_container = isinstance(column, columns.BaseContainerColumn)
+            if not fields or column.db_field_name in selected:
+                loaded.append((name, column.db_field_name, column, column.value_manager,
+                               columns.db_value_converter(column), is_container))
+            else:
+                unloaded.append((name, column, column.value_manager, is_container))
+
+        new = object.__new__
+        default_ttl = cls.__default_ttl__
+        not_set = connection.NOT_SET
+        missing = object()
+
+        def constructor(row):
+            instance = new(cls)
+            values = {}
+            get = row.get
+            for name, db_name, column, value_manager, convert, is_container in loaded:
+                value = get(db_name, missing)
+                explicit = value is not missing
+                if not explicit:
+                    value = None
+                if convert is not None and (value is not None or is_container):
+                    value = convert(value)
+                value_mngr = value_manager(instance, column, value)
+                value_mngr.explicit = explicit
+                values[name] = value_mngr
+            for name, column, value_manager, is_container in unloaded:
+                values[name] = value_manager(instance, column, column.to_python(None) if is_container else None)
+
+            instance._values = values
+            instance._ttl = default_ttl
+            instance._timestamp = None
+            instance._transaction = None
+            instance._is_persisted = True
+            instance._batch = None
+            instance._timeout = not_set
+            return instance
+
+        cls._row_constructors[fields] = constructor
+        return constructor
+
     def _can_update(self):
         """
         Called by the save function to check if this should be
@@ -906,6 +996,9 @@ class ModelMetaClass(type):
         attrs['_discriminator_column_name'] = discriminator_column_name
         attrs['_discriminator_map'] = {} if is_polymorphic_base else None
 
+        # functions building instances from query results, by selected columns
+        attrs['_row_constructors'] = {}
+
         # setup class exceptions
         DoesNotExistBase = None
         for base in bases:
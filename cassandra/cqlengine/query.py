@@ -804,7 +804,7 @@ class ModelQuerySet(AbstractQuerySet):
     def _get_result_constructor(self):
         """ Returns a function that will be used to instantiate query results """
         if not self._values_list:  # we want models
-            return lambda rows: self.model._construct_instance(rows)
+            return self.model._get_row_constructor(self._select_fields())
         elif self._flat_values_list:  # the user has requested flattened list (1 value per row)
             return lambda row: row.popitem()[1]
         else:
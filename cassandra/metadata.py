@@ -13,7 +13,8 @@
 # limitations under the License.
 
 from bisect import bisect_right
-from collections import defaultdict
+from collections import defaultdict, MutableMapping
+from functools import partial
 from hashlib import md5
 from itertools import islice, cycle
 import json
@@ -116,12 +117,14 @@ class Metadata(object):
             keyspace_col_rows = col_def_rows.get(keyspace_meta.name, {})
             keyspace_trigger_rows = trigger_rows.get(keyspace_meta.name, {})
             for table_row in cf_def_rows.get(keyspace_meta.name, []):
-                table_meta = self._build_table_metadata(keyspace_meta, table_row, keyspace_col_rows, keyspace_trigger_rows)
-                keyspace_meta._add_table_metadata(table_meta)
+                cfname = table_row["columnfamily_name"]
+                self._add_table_rows(keyspace_meta, table_row,
+                                     keyspace_col_rows.get(cfname, []),
+                                     keyspace_trigger_rows.get(cfname, []))
 
             for usertype_row in usertype_rows.get(keyspace_meta.name, []):
-                usertype = self._build_usertype(keyspace_meta.name, usertype_row)
-                keyspace_meta.user_types[usertype.name] = usertype
+                keyspace_meta.user_types.set_loader(
+                    usertype_row['type_name'], partial(self._build_usertype, keyspace_meta.name, usertype_row))
 
             current_keyspaces.add(keyspace_meta.name)
             old_keyspace_meta = self.keyspaces.get(keyspace_meta.name, None)
@@ -153,6 +156,7 @@ class Metadata(object):
             keyspace_meta.tables = old_keyspace_meta.tables
             keyspace_meta.user_types = old_keyspace_meta.user_types
             keyspace_meta.indexes = old_keyspace_meta.indexes
+            keyspace_meta._table_index_names = old_keyspace_meta._table_index_names
             if (keyspace_meta.replication_strategy != old_keyspace_meta.replication_strategy):
                 self._keyspace_updated(keyspace)
         else:
@@ -164,7 +168,7 @@ class Metadata(object):
             self.keyspaces[keyspace].user_types[name] = new_usertype
         else:
             # the type was deleted
-            self.keyspaces[keyspace].user_types.pop(name, None)
+            self.keyspaces[keyspace].user_types.discard(name)
 
     def table_changed(self, keyspace, table, cf_results, col_results, triggers_result):
         try:
@@ -180,8 +184,18 @@ class Metadata(object):
             keyspace_meta._drop_table_metadata(table)
         else:
             assert len(cf_results) == 1
-            table_meta = self._build_table_metadata(keyspace_meta, cf_results[0], {table: col_results}, {table: triggers_result})
-            keyspace_meta._add_table_metadata(table_meta)
+            self._add_table_rows(keyspace_meta, cf_results[0], col_results, triggers_result)
+
+    def _add_table_rows(self, keyspace_meta, row, col_rows, trigger_rows):
+        """
+        Registers the raw rows for a table with `keyspace_meta`; the
+        :class:`.TableMetadata` is only built when it is first accessed.
+        """
+        cfname = row["columnfamily_name"]
+        index_names = [r.get("index_name") for r in col_rows if r.get("index_name")]
+        loader = partial(self._build_table_metadata, keyspace_meta, row,
+                         {cfname: col_rows}, {cfname: trigger_rows})
+        keyspace_meta._add_table_loader(cfname, loader, index_names)
 
     def _keyspace_added(self, ksname):
         if self.token_map:
@@ -397,10 +411,14 @@ class Metadata(object):
         trigger_meta = TriggerMetadata(table_metadata, name, options)
         return trigger_meta
 
-    def rebuild_token_map(self, partitioner, token_map):
+    def rebuild_token_map(self, partitioner, token_map, snapshot=None, compute_digest=False):
         """
         Rebuild our view of the topology from fresh rows from the
-        system topology tables.
+        system topology tables.  If `snapshot` is a
+        :class:`~.SnapshotContents` built from the same topology, its ring
+        and replica maps are reused instead of being computed.  The
+        topology digest is only computed when there is a `snapshot` or
+        `compute_digest` is set, since it hashes every token.
         For internal use only.
         """
         self.partitioner = partitioner
@@ -414,6 +432,18 @@ class Metadata(object):
             self.token_map = None
             return
 
+        digest = None
+        if snapshot is not None or compute_digest:
+            digest = topology_digest(partitioner, token_map)
+        if snapshot is not None and snapshot.topology_digest == digest:
+            built = snapshot.build_ring(token_class, self)
+            if built:
+                token_to_host_owner, all_tokens = built
+                log.debug("Reusing token ring from metadata snapshot generation %d", snapshot.generation)
+                self.token_map = TokenMap(
+                    token_class, token_to_host_owner, all_tokens, self, digest, snapshot)
+                return
+
         token_to_host_owner = {}
         ring = []
         for host, token_strings in six.iteritems(token_map):
@@ -424,7 +454,7 @@ class Metadata(object):
 
         all_tokens = sorted(ring)
         self.token_map = TokenMap(
-            token_class, token_to_host_owner, all_tokens, self)
+            token_class, token_to_host_owner, all_tokens, self, digest)
 
     def get_replicas(self, keyspace, key):
         """
@@ -477,6 +507,20 @@ class Metadata(object):
 REPLICATION_STRATEGY_CLASS_PREFIX = "org.apache.cassandra.locator."
 
 
+def topology_digest(partitioner, token_map):
+    """
+    Returns a hex digest identifying a ring layout, where `token_map` maps
+    :class:`~.Host` instances to the token strings they own.  Processes that
+    observe the same hosts, locations and tokens compute the same digest.
+    """
+    digest = md5(partitioner.encode('utf-8'))
+    for host, token_strings in sorted(token_map.items(), key=lambda item: item[0].address):
+        line = "\n%s|%s|%s|%s" % (host.address, host.datacenter, host.rack,
+                                  ",".join(sorted(token_strings)))
+        digest.update(line.encode('utf-8'))
+    return digest.hexdigest()
+
+
 def trim_if_startswith(s, prefix):
     if s.startswith(prefix):
         return s[len(prefix):]
@@ -727,11 +771,15 @@ class KeyspaceMetadata(object):
     tables = None
     """
     A map from table names to instances of :class:`~.TableMetadata`.
+
+    Tables are built from the raw schema rows the first time they are
+    accessed, so iterating over :meth:`values()` or :meth:`items()` is more
+    expensive than looking up a single table or listing the names.
     """
 
     indexes = None
     """
-    A dict mapping index names to :class:`.IndexMetadata` instances.
+    A dict-like map from index names to :class:`.IndexMetadata` instances.
     """
 
     user_types = None
@@ -745,9 +793,13 @@ class KeyspaceMetadata(object):
         self.name = name
         self.durable_writes = durable_writes
         self.replication_strategy = ReplicationStrategy.create(strategy_class, strategy_options)
-        self.tables = {}
-        self.indexes = {}
-        self.user_types = {}
+
+        # tables and indexes are materialized together, so they share a lock
+        lock = RLock()
+        self.tables = LazyMetadataMap(lock)
+        self.indexes = LazyMetadataMap(lock)
+        self.user_types = LazyMetadataMap()
+        self._table_index_names = {}
 
     def export_as_string(self):
         """
@@ -768,7 +820,7 @@ class KeyspaceMetadata(object):
 
     def user_type_strings(self):
         user_type_strings = []
-        types = self.user_types.copy()
+        types = dict(self.user_types)
         keys = sorted(types.keys())
         for k in keys:
             if k in types:
@@ -786,14 +838,120 @@ class KeyspaceMetadata(object):
         self._drop_table_metadata(table_metadata.name)
 
         self.tables[table_metadata.name] = table_metadata
+        self._add_table_indexes(table_metadata)
+
+    def _add_table_loader(self, table_name, loader, index_names=()):
+        with self.tables.lock:
+            self._drop_table_metadata(table_name)
+
+            self.tables.set_loader(table_name, partial(self._load_table, loader))
+            self._table_index_names[table_name] = list(index_names)
+            for index_name in index_names:
+                self.indexes.set_loader(index_name, partial(self._load_index, table_name, index_name))
+
+    def _load_table(self, loader):
+        table_metadata = loader()
+        self._add_table_indexes(table_metadata)
+        return table_metadata
+
+    def _load_index(self, table_name, index_name):
+        return self.tables[table_name].indexes[index_name]
+
+    def _add_table_indexes(self, table_metadata):
+        self._table_index_names[table_metadata.name] = list(table_metadata.indexes)
         for index_name, index_metadata in six.iteritems(table_metadata.indexes):
             self.indexes[index_name] = index_metadata
 
     def _drop_table_metadata(self, table_name):
-        table_meta = self.tables.pop(table_name, None)
-        if table_meta:
-            for index_name in table_meta.indexes:
-                self.indexes.pop(index_name, None)
+        with self.tables.lock:
+            self.tables.discard(table_name)
+            for index_name in self._table_index_names.pop(table_name, ()):
+                self.indexes.discard(index_name)
+
+
+_MISSING = object()
+
+
+class LazyMetadataMap(MutableMapping):
+    """
+    A dict-like map whose values may be registered as loader functions.
+    A loader is called the first time its key is looked up, and the
+    result replaces it.  Membership tests, ``len()`` and iterating over the
+    keys never call loaders.
+
+    Membership tests and ``len()`` do not take the lock, so a key that moves
+    from a loader to a value is stored as a value before its loader is
+    dropped, and the number of keys is kept separately.
+    """
+
+    lock = None
+    """ The lock held while a value is loaded or the map is mutated. """
+
+    def __init__(self, lock=None):
+        self.lock = lock or RLock()
+        self._values = {}
+        self._loaders = {}
+        self._size = 0
+
+    def set_loader(self, key, loader):
+        with self.lock:
+            if key not in self:
+                self._size += 1
+            self._loaders[key] = loader
+            self._values.pop(key, None)
+
+    def is_loaded(self, key):
+        return key in self._values
+
+    def discard(self, key):
+        """ Removes `key` if it is present, without loading it. """
+        with self.lock:
+            if self._values.pop(key, _MISSING) is not _MISSING or self._loaders.pop(key, _MISSING) is not _MISSING:
+                self._size -= 1
+
+    def __getitem__(self, key):
+        try:
+            return self._values[key]
+        except KeyError:
+            pass
+
+        with self.lock:
+            if key in self._values:
+                return self._values[key]
+            value = self._loaders[key]()
+            # the loader may have stored the value itself
+            if key in self._loaders:
+                self._values[key] = value
+                del self._loaders[key]
+            return value
+
+    def __setitem__(self, key, value):
+        with self.lock:
+            if key not in self:
+                self._size += 1
+            self._values[key] = value
+            self._loaders.pop(key, None)
+
+    def __delitem__(self, key):
+        with self.lock:
+            if self._values.pop(key, _MISSING) is _MISSING and self._loaders.pop(key, _MISSING) is _MISSING:
+                raise KeyError(key)
+            self._size -= 1
+
+    def __contains__(self, key):
+        return key in self._values or key in self._loaders
+
+    def __iter__(self):
+        with self.lock:
+            keys = list(self._values) + list(self._loaders)
+        return iter(keys)
+
+    def __len__(self):
+        return self._size
+
+    def __repr__(self):
+        return "%s(%r)" % (self.__class__.__name__, sorted(self))
+
 
 class UserType(object):
     """
@@ -1295,15 +1453,25 @@ class TokenMap(object):
     An ordered list of :class:`.Token` instances in the ring.
     """
 
+    topology_digest = None
+    """
+    A digest of the hosts and tokens this map was built from, as returned
+    by :func:`.topology_digest()`.
+    """
+
     _metadata = None
+    _snapshot = None
 
-    def __init__(self, token_class, token_to_host_owner, all_tokens, metadata):
+    def __init__(self, token_class, token_to_host_owner, all_tokens, metadata,
+                 topology_digest=None, snapshot=None):
         self.token_class = token_class
         self.ring = all_tokens
         self.token_to_host_owner = token_to_host_owner
+        self.topology_digest = topology_digest
 
         self.tokens_to_hosts_by_ks = {}
         self._metadata = metadata
+        self._snapshot = snapshot
         self._rebuild_lock = RLock()
 
     def rebuild_keyspace(self, keyspace, build_if_absent=False):
@@ -1316,6 +1484,10 @@ class TokenMap(object):
     def replica_map_for_keyspace(self, ks_metadata):
         strategy = ks_metadata.replication_strategy
         if strategy:
+            if self._snapshot:
+                replica_map = self._snapshot.replica_map(strategy, self.ring, self._metadata)
+                if replica_map is not None:
+                    return replica_map
             return strategy.make_token_replica_map(self.token_to_host_owner, self.ring)
         else:
             return None
@@ -17,6 +17,7 @@ Connection pooling and host management.
 """
 
 import logging
+from random import random
 import socket
 import time
 from threading import Lock, RLock, Condition
@@ -262,6 +263,44 @@ class _HostReconnectionHandler(_ReconnectionHandler):
             return True
 
 
+def _pick_least_busy(connections):
+    """
+    Returns the less busy of two randomly chosen connections (the "power of
+    two choices"), which spreads load nearly as evenly as scanning every
+    connection, without the scan.
+    """
+    n = len(connections)
+    if n == 1:
+        return connections[0]
+    i = int(random() * n)
+    j = int(random() * (n - 1))
+    if j >= i:
+        j += 1
+    a, b = connections[i], connections[j]
+    return a if a.in_flight <= b.in_flight else b
+
+
+def _reserve_request_id(connection):
+    """
+    Increments the in-flight count of `connection` and returns a free request
+    id for it, or :const:`None` if the connection is at capacity.  Only the
+    connection's own lock is taken, and not at all if the (unlocked) in-flight
+    count already shows it to be full.
+    """
+    if connection.in_flight >= connection.max_request_id:
+        return None
+
+    # to avoid another thread closing this connection while
+    # trashing it (through the return_connection process), hold
+    # the connection lock from this point until we've incremented
+    # its in_flight count
+    with connection.lock:
+        if connection.in_flight < connection.max_request_id:
+            connection.in_flight += 1
+            return connection.get_request_id()
+    return None
+
+
 class HostConnection(object):
     """
     When using v3 of the native protocol, this is used instead of a connection
@@ -305,12 +344,10 @@ class HostConnection(object):
         if not conn:
             raise NoConnectionsAvailable()
 
-        with conn.lock:
-            if conn.in_flight < conn.max_request_id:
-                conn.in_flight += 1
-                return conn, conn.get_request_id()
-
-        raise NoConnectionsAvailable("All request IDs are currently in use")
+        request_id = _reserve_request_id(conn)
+        if request_id is None:
+            raise NoConnectionsAvailable("All request IDs are currently in use")
+        return conn, request_id
 
     def return_connection(self, connection):
         with connection.lock:
@@ -392,6 +429,7 @@ class HostConnectionPool(object):
     open_count = 0
     _scheduled_for_creation = 0
     _next_trash_allowed_at = 0
+    _waiters = 0
 
     def __init__(self, host, host_distance, session):
         self.host = host
@@ -444,34 +482,43 @@ class HostConnectionPool(object):
             max_reqs = self._session.cluster.get_max_requests_per_connection(self.host_distance)
             max_conns = self._session.cluster.get_max_connections_per_host(self.host_distance)
 
-            least_busy = min(conns, key=lambda c: c.in_flight)
-            request_id = None
-            # to avoid another thread closing this connection while
-            # trashing it (through the return_connection process), hold
-            # the connection lock from this point until we've incremented
-            # its in_flight count
-            need_to_wait = False
-            with least_busy.lock:
-                if least_busy.in_flight < least_busy.max_request_id:
-                    least_busy.in_flight += 1
-                    request_id = least_busy.get_request_id()
-                else:
-                    # once we release the lock, wait for another connection
-                    need_to_wait = True
-
-            if need_to_wait:
+            least_busy, request_id = self._borrow_least_busy(conns)
+            if least_busy is None:
                 # wait_for_conn will increment in_flight on the conn
                 least_busy, request_id = self._wait_for_conn(timeout)
 
-            # if we have too many requests on this connection but we still
+            # if we have too many requests on every connection but we still
             # have space to open a new connection against this host, go ahead
-            # and schedule the creation of a new connection
-            if least_busy.in_flight >= max_reqs and len(self._connections) < max_conns:
+            # and schedule the creation of a new connection.  The sampled
+            # connection being busy doesn't mean the others are, so only then
+            # is the whole pool checked.
+            if least_busy.in_flight >= max_reqs and len(self._connections) < max_conns and \
+                    min(c.in_flight for c in conns) >= max_reqs:
                 self._maybe_spawn_new_connection()
 
             return least_busy, request_id
 
+    def _borrow_least_busy(self, conns):
+        """
+        Reserves a request on the less busy of two random connections, only
+        falling back to the least busy of all of them if that one is full.
+        Returns ``(None, None)`` if every connection is at capacity.
+        """
+        conn = _pick_least_busy(conns)
+        request_id = _reserve_request_id(conn)
+        if request_id is None and len(conns) > 1:
+            conn = min(conns, key=lambda c: c.in_flight)
+            request_id = _reserve_request_id(conn)
+        if request_id is None:
+            return None, None
+        return conn, request_id
+
     def _maybe_spawn_new_connection(self):
+        # checked without the lock first, since this is called on every
+        # borrow while the pool is saturated
+        if self._scheduled_for_creation >= _MAX_SIMULTANEOUS_CREATION:
+            return
+
         with self._lock:
             if self._scheduled_for_creation >= _MAX_SIMULTANEOUS_CREATION:
                 return
@@ -531,9 +578,21 @@ class HostConnectionPool(object):
 
     def _await_available_conn(self, timeout):
         with self._conn_available_condition:
-            self._conn_available_condition.wait(timeout)
+            # we register as a waiter before checking for capacity, so a
+            # return_connection() that sees no waiters and skips signaling
+            # must already have freed up its request slot
+            self._waiters += 1
+            try:
+                if not self.is_shutdown and not any(c.in_flight < c.max_request_id for c in self._connections):
+                    self._conn_available_condition.wait(timeout)
+            finally:
+                self._waiters -= 1
 
     def _signal_available_conn(self):
+        # avoid taking the condition's lock for every returned
+        # connection when nobody is waiting
+        if not self._waiters:
+            return
         with self._conn_available_condition:
             self._conn_available_condition.notify()
 
@@ -556,11 +615,9 @@ class HostConnectionPool(object):
 
             conns = self._connections
             if conns:
-                least_busy = min(conns, key=lambda c: c.in_flight)
-                with least_busy.lock:
-                    if least_busy.in_flight < least_busy.max_request_id:
-                        least_busy.in_flight += 1
-                        return least_busy, least_busy.get_request_id()
+                least_busy, request_id = self._borrow_least_busy(conns)
+                if least_busy is not None:
+                    return least_busy, request_id
 
             remaining = timeout - (time.time() - start)
 
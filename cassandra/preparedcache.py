@@ -0,0 +1,267 @@
+# Copyright 2013-2015 DataStax, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+An on-disk cache of prepared statements for warm restarts.
+
+Statements prepared by a process are written to a file keyed by the
+cluster name and schema version.  When the process (or any other process
+using the same file) starts again against an unchanged schema, calls to
+:meth:`.Session.prepare()` are answered from the file instead of sending
+``PREPARE`` requests to the cluster.  Hosts that do not know a cached
+statement reply with an "unprepared" error, at which point the statement is
+re-prepared on that host alone, exactly as after a host restart.
+"""
+
+import logging
+import mmap
+import os
+import struct
+import tempfile
+from threading import Lock
+
+from six.moves import cPickle as pickle
+
+from cassandra.cqltypes import UserType, lookup_casstype_simple
+from cassandra.query import PreparedStatement
+
+log = logging.getLogger(__name__)
+
+_MAGIC = b'CPSC'
+_FORMAT_VERSION = 1
+
+# magic, format version, payload length
+_header = struct.Struct('>4sB3xI')
+HEADER_SIZE = _header.size
+
+
+class PreparedStatementCache(object):
+    """
+    Persists the query ids, bind column metadata and routing key indexes of
+    prepared statements to the file at `path`.  Pass an instance to a
+    :class:`~.Cluster` with the `prepared_statement_cache` argument.
+
+    Cached entries are only used once the control connection has confirmed
+    that the cluster name and schema version match the ones they were
+    written under; they are dropped when the schema version changes or when
+    a host reports one of them as unprepared.  Only statements prepared (or
+    read from the file) under the current schema version are written back.
+
+    The file is read with :mod:`pickle`, so only trusted processes should be
+    able to write to it.
+
+    Example usage::
+
+        >>> cache = PreparedStatementCache('/var/run/myapp/prepared.cache')
+        >>> cluster = Cluster(prepared_statement_cache=cache)
+        >>> session = cluster.connect('mykeyspace')
+        >>> # no PREPARE is sent if this was prepared before the last restart
+        >>> prepared = session.prepare("SELECT * FROM users WHERE id=?")
+
+    .. versionadded:: 2.6.0
+    """
+
+    path = None
+    """ The path of the cache file. """
+
+    cluster_name = None
+    """ The cluster name last passed to :meth:`.set_schema_version()`. """
+
+    schema_version = None
+    """ The schema version last passed to :meth:`.set_schema_version()`. """
+
+    def __init__(self, path):
+        self.path = path
+        self._lock = Lock()
+        self._write_lock = Lock()
+        self._entries = {}
+        self._dirty = False
+        self._loaded_key = None
+        self._loaded_entries = {}
+        self._load()
+
+    def set_schema_version(self, cluster_name, schema_version):
+        """
+        Called by the control connection whenever it observes the schema
+        version the whole cluster agrees on.  Entries read from the file are
+        only usable while this matches the key they were written under.
+        """
+        with self._lock:
+            if (cluster_name, schema_version) == (self.cluster_name, self.schema_version):
+                return
+            self.cluster_name, self.schema_version = cluster_name, schema_version
+            if self._loaded_key == (cluster_name, schema_version):
+                self._entries = dict(self._loaded_entries)
+            else:
+                if self._entries:
+                    log.debug("Discarding %d cached prepared statements after schema version changed to %s",
+                              len(self._entries), schema_version)
+                self._entries = {}
+            # the file is only ever usable under one key
+            self._loaded_key = None
+            self._loaded_entries = {}
+
+    def get(self, query, keyspace, protocol_version, user_type_map=None):
+        """
+        Returns a :class:`~.PreparedStatement` for `query` as prepared in
+        `keyspace`, or :const:`None` if there is no usable cached entry.
+        `user_type_map` is used to map user types in the bind metadata to
+        registered classes, as for results.
+        """
+        entry = self._entries.get((keyspace, query))
+        if entry is None:
+            return None
+
+        query_id, entry_protocol_version, routing_key_indexes, column_metadata = entry
+        if entry_protocol_version != protocol_version:
+            return None
+
+        try:
+            column_metadata = [(ks, cf, name, _decode_type(typ, user_type_map or {}))
+                               for ks, cf, name, typ in column_metadata]
+        except Exception:
+            log.warning("Ignoring cached prepared statement that could not be decoded: %s", query, exc_info=True)
+            self.discard(query_id)
+            return None
+
+        return PreparedStatement(column_metadata, query_id, routing_key_indexes,
+                                 query, keyspace, protocol_version)
+
+    def add(self, prepared_statement, cluster_name, schema_version):
+        """
+        Records `prepared_statement`, whose bind metadata was returned while
+        the cluster reported `cluster_name` and `schema_version`, to be written
+        by the next :meth:`.save()`.  Returns :const:`True` if it was
+        recorded, or :const:`False` if the schema version has changed since
+        (or was not yet known) and the metadata may be stale.
+        """
+        if schema_version is None:
+            return False
+
+        try:
+            column_metadata = tuple((ks, cf, name, _encode_type(typ))
+                                    for ks, cf, name, typ in prepared_statement.column_metadata or ())
+        except Exception:
+            log.debug("Not caching prepared statement with unsupported metadata: %s",
+                      prepared_statement.query_string, exc_info=True)
+            return False
+
+        with self._lock:
+            if (cluster_name, schema_version) != (self.cluster_name, self.schema_version):
+                return False
+            self._entries[(prepared_statement.keyspace, prepared_statement.query_string)] = (
+                prepared_statement.query_id, prepared_statement.protocol_version,
+                prepared_statement.routing_key_indexes, column_metadata)
+            self._dirty = True
+        return True
+
+    def discard(self, query_id):
+        """
+        Drops any cached entry with `query_id`, typically because a host
+        reported it as unprepared.
+        """
+        with self._lock:
+            for key, entry in list(self._entries.items()):
+                if entry[0] == query_id:
+                    del self._entries[key]
+                    self._dirty = True
+
+    def save(self):
+        """
+        Writes the entries usable under the current :attr:`.cluster_name`
+        and :attr:`.schema_version` to the cache file, replacing its previous
+        contents.  Does nothing if they have not changed since the last save.
+        """
+        with self._write_lock:
+            with self._lock:
+                if not self._dirty:
+                    return
+                self._dirty = False
+                cluster_name, schema_version = self.cluster_name, self.schema_version
+                entries = list(self._entries.items())
+
+            statements = [(keyspace, query, query_id, protocol_version, routing_key_indexes, column_metadata)
+                          for (keyspace, query), (query_id, protocol_version, routing_key_indexes, column_metadata)
+                          in entries]
+            try:
+                self._write(pickle.dumps((cluster_name, schema_version, statements), 2))
+            except Exception:
+                with self._lock:
+                    self._dirty = True
+                raise
+
+    def _write(self, payload):
+        directory = os.path.dirname(os.path.abspath(self.path))
+        fd, tmp_path = tempfile.mkstemp(dir=directory, prefix='.prepared-')
+        try:
+            with os.fdopen(fd, 'wb') as f:
+                f.write(_header.pack(_MAGIC, _FORMAT_VERSION, len(payload)))
+                f.write(payload)
+            # atomic, so concurrent readers never see a partial file
+            os.rename(tmp_path, self.path)
+        except Exception:
+            os.unlink(tmp_path)
+            raise
+
+    def __len__(self):
+        return len(self._entries)
+
+    def _load(self):
+        try:
+            with open(self.path, 'rb') as f:
+                if os.fstat(f.fileno()).st_size < HEADER_SIZE:
+                    return
+                m = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+                try:
+                    magic, version, length = _header.unpack_from(m, 0)
+                    if magic != _MAGIC or version != _FORMAT_VERSION or len(m) < HEADER_SIZE + length:
+                        log.debug("Ignoring prepared statement cache %s with unknown format", self.path)
+                        return
+                    cluster_name, schema_version, statements = pickle.loads(m[HEADER_SIZE:HEADER_SIZE + length])
+                finally:
+                    m.close()
+        except (IOError, OSError):
+            return
+        except Exception:
+            log.warning("Ignoring unreadable prepared statement cache %s", self.path, exc_info=True)
+            return
+
+        self._loaded_key = (cluster_name, schema_version)
+        self._loaded_entries = dict(((keyspace, query), (query_id, protocol_version, routing_key_indexes, column_metadata))
+                                    for keyspace, query, query_id, protocol_version, routing_key_indexes, column_metadata
+                                    in statements)
+        log.debug("Loaded %d prepared statements from %s", len(self._loaded_entries), self.path)
+
+
+def _encode_type(typ):
+    if issubclass(typ, UserType):
+        return ('udt', typ.keyspace, typ.typename,
+                tuple((name, _encode_type(subtype)) for name, subtype in zip(typ.fieldnames, typ.subtypes)))
+    subtypes = tuple(_encode_type(subtype) for subtype in typ.subtypes)
+    return ('type', typ.cassname, subtypes, tuple(getattr(typ, 'fieldnames', None) or ()))
+
+
+def _decode_type(encoded, user_type_map):
+    if encoded[0] == 'udt':
+        _, keyspace, udt_name, fields = encoded
+        names_and_types = tuple((name, _decode_type(subtype, user_type_map)) for name, subtype in fields)
+        mapped_class = user_type_map.get(keyspace, {}).get(udt_name)
+        return UserType.make_udt_class(keyspace, udt_name, names_and_types, mapped_class)
+
+    _, cassname, subtypes, names = encoded
+    typ = lookup_casstype_simple(cassname)
+    if subtypes:
+        typ = typ.apply_parameters([_decode_type(subtype, user_type_map) for subtype in subtypes],
+                                   list(names) or None)
+    return typ
@@ -0,0 +1,437 @@
+# Copyright 2013-2015 DataStax, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Shared-memory snapshots of cluster metadata for pre-fork servers.
+
+A process that owns a fully connected :class:`~.Cluster` publishes the
+token ring, the per-keyspace replica maps, the raw schema rows and the ids
+of its prepared statements into an mmap'd region.  Worker processes
+forked from it (or attached to the same file) reuse that state instead
+of recomputing it, as long as it still matches what their own control
+connection observes.
+"""
+
+import logging
+import mmap
+import os
+import struct
+from threading import Lock
+import time
+
+import six
+from six.moves import cPickle as pickle
+from six.moves import range
+
+log = logging.getLogger(__name__)
+
+DEFAULT_CAPACITY = 16 * 1024 * 1024
+
+_MAGIC = b'CSNP'
+_FORMAT_VERSION = 2
+
+# magic, format version, generation, generation the metadata section was
+# last written at, metadata section length, prepared section length
+_header = struct.Struct('>4sB3xQQQQ')
+HEADER_SIZE = _header.size
+
+# the header is written in two parts, so that the generation can be
+# updated after everything it covers
+_header_start = struct.Struct('>4sB3xQ')
+_header_rest = struct.Struct('>QQQ')
+
+_MAX_READ_ATTEMPTS = 100
+
+
+class MetadataSnapshot(object):
+    """
+    A versioned, read-mostly snapshot of cluster metadata held in an
+    mmap'd region.
+
+    The process that creates a :class:`.MetadataSnapshot` is its publisher;
+    every other process that sees the same region (children created with
+    ``os.fork()`` after construction, or processes using :meth:`attach()`)
+    only reads from it.  Pass the instance to a :class:`~.Cluster` with the
+    `metadata_snapshot` argument in both the publishing and the reading
+    processes.
+
+    If `path` is :const:`None`, an anonymous shared mapping of `capacity`
+    bytes is used.  It must be created before forking and cannot grow.
+    Otherwise the mapping is backed by the file at `path`, which is created
+    with owner-only permissions and grown as needed.  Only trusted processes
+    should be able to write to that file.
+
+    Example usage with a pre-fork server::
+
+        >>> snapshot = MetadataSnapshot()
+        >>> cluster = Cluster(metadata_snapshot=snapshot)
+        >>> cluster.connect().shutdown()   # publishes ring and schema
+        >>> cluster.shutdown()
+        >>> # ... fork workers; in each worker:
+        >>> cluster = Cluster(metadata_snapshot=snapshot)
+        >>> session = cluster.connect()
+
+    .. versionadded:: 2.6.0
+    """
+
+    path = None
+    """ The path of the backing file, or :const:`None` for an anonymous mapping. """
+
+    _mmap = None
+    _fd = None
+    _owner_pid = None
+    _loaded = None
+    _loaded_generation = 0
+    _loaded_state = None
+    _loaded_metadata_generation = 0
+
+    def __init__(self, path=None, capacity=DEFAULT_CAPACITY):
+        self.path = path
+        self._lock = Lock()
+        self._owner_pid = os.getpid()
+        self._schema_version = None
+        self._schema_rows = None
+        self._prepared = ()
+
+        capacity = max(capacity, HEADER_SIZE)
+        if path is None:
+            self._mmap = mmap.mmap(-1, capacity)
+        else:
+            self._fd = os.open(path, os.O_RDWR | os.O_CREAT, 0o600)
+            capacity = max(capacity, os.fstat(self._fd).st_size)
+            os.ftruncate(self._fd, capacity)
+            self._mmap = mmap.mmap(self._fd, capacity)
+
+        magic, version, generation = self._read_header()[:3]
+        if magic != _MAGIC or version != _FORMAT_VERSION:
+            self._write_header(0, 0, 0, 0)
+        elif generation & 1:
+            # a previous publisher died mid-write
+            self._write_header(generation + 1, 0, 0, 0)
+
+    @classmethod
+    def attach(cls, path):
+        """
+        Attaches read-only to a snapshot file published by another process.
+        """
+        self = cls.__new__(cls)
+        self.path = path
+        self._lock = Lock()
+        self._fd = os.open(path, os.O_RDONLY)
+        self._map_file()
+        return self
+
+    @property
+    def is_publisher(self):
+        """
+        :const:`True` if this process publishes to the snapshot, :const:`False`
+        if it only reads from it.
+        """
+        return self._owner_pid == os.getpid()
+
+    @property
+    def generation(self):
+        """
+        A counter that is incremented every time a new snapshot is published.
+        Zero if nothing has been published yet; odd while a publish is in
+        progress.
+        """
+        return self._read_header()[2]
+
+    def set_schema_rows(self, schema_version, schema_rows):
+        """
+        Sets the raw system schema rows (a tuple of keyspace, usertype,
+        columnfamily, column and trigger rows) fetched while the cluster
+        reported `schema_version`.  They are written out by the next
+        :meth:`publish()`.
+        """
+        self._schema_version = schema_version
+        self._schema_rows = schema_rows
+
+    def set_prepared_statements(self, prepared_statements):
+        """
+        Sets the :class:`~.PreparedStatement` instances whose ids are written
+        out by the next :meth:`publish()` or :meth:`publish_prepared()`.
+        """
+        self._prepared = tuple(s.query_id for s in prepared_statements)
+
+    def publish_prepared(self):
+        """
+        Writes only the prepared statement ids set by
+        :meth:`set_prepared_statements()`, keeping the rest of the last
+        published snapshot, and increments :attr:`.generation`.  Unlike
+        :meth:`publish()`, the cost does not depend on the size of the schema.
+        """
+        if not self.is_publisher:
+            raise RuntimeError("Only the process that created a MetadataSnapshot may publish to it")
+
+        self._write(pickle.dumps(self._prepared, 2))
+
+    def publish(self, metadata):
+        """
+        Writes a new snapshot of `metadata` (a :class:`~.Metadata` instance)
+        and increments :attr:`.generation`.  Replica maps are computed for
+        every known keyspace that does not have one yet.
+        """
+        if not self.is_publisher:
+            raise RuntimeError("Only the process that created a MetadataSnapshot may publish to it")
+
+        state = {
+            'partitioner': metadata.partitioner,
+            'schema_version': self._schema_version,
+            'schema_rows': self._schema_rows
+        }
+
+        token_map = metadata.token_map
+        # workers can only match a ring published with its digest
+        if token_map and token_map.topology_digest:
+            hosts = sorted(set(token_map.token_to_host_owner.values()), key=lambda h: h.address)
+            host_index = dict((host, i) for i, host in enumerate(hosts))
+            ring = token_map.ring
+
+            replica_maps = {}
+            for ks_name, ks_meta in list(metadata.keyspaces.items()):
+                strategy = ks_meta.replication_strategy
+                if not strategy:
+                    continue
+                key = strategy.export_for_schema()
+                if key in replica_maps:
+                    continue
+                token_map.rebuild_keyspace(ks_name, build_if_absent=True)
+                replica_map = token_map.tokens_to_hosts_by_ks.get(ks_name)
+                if replica_map and len(replica_map) == len(ring):
+                    replica_maps[key] = _pack_replica_map(replica_map, ring, host_index)
+
+            state.update({
+                'topology_digest': token_map.topology_digest,
+                'hosts': [(h.address, h.datacenter, h.rack) for h in hosts],
+                'ring': _pack_ring(ring),
+                'owners': _pack_indexes(host_index[token_map.token_to_host_owner[t]] for t in ring),
+                'replica_maps': replica_maps
+            })
+
+        self._write(pickle.dumps(self._prepared, 2), pickle.dumps(state, 2))
+
+    def load(self):
+        """
+        Returns the most recently published :class:`.SnapshotContents`, or
+        :const:`None` if nothing has been published.  The result is cached
+        until the :attr:`.generation` changes.
+        """
+        for _ in range(_MAX_READ_ATTEMPTS):
+            header = self._read_header()
+            if header[0] != _MAGIC and self._fd is not None and not self.is_publisher:
+                self._map_file()
+                header = self._read_header()
+            magic, version, generation, metadata_generation, metadata_length, prepared_length = header
+            if magic != _MAGIC or version != _FORMAT_VERSION or generation == 0:
+                return None
+            if generation & 1:
+                time.sleep(0.001)
+                continue
+            if generation == self._loaded_generation:
+                return self._loaded
+
+            prepared_offset = HEADER_SIZE + metadata_length
+            if len(self._mmap) < prepared_offset + prepared_length:
+                self._map_file()
+            # only the prepared section changes when statements are prepared
+            reuse_state = self._loaded_state is not None and metadata_generation == self._loaded_metadata_generation
+            if not reuse_state:
+                metadata_payload = self._mmap[HEADER_SIZE:prepared_offset]
+            prepared_payload = self._mmap[prepared_offset:prepared_offset + prepared_length]
+            # a torn header can pair this generation with stale lengths,
+            # so everything that was used must be unchanged
+            if self._read_header() != header:
+                continue
+
+            if reuse_state:
+                state = self._loaded_state
+            else:
+                state = pickle.loads(metadata_payload) if metadata_length else {}
+            prepared = pickle.loads(prepared_payload) if prepared_length else ()
+            contents = SnapshotContents(generation, state, prepared)
+            self._loaded, self._loaded_generation = contents, generation
+            self._loaded_state, self._loaded_metadata_generation = state, metadata_generation
+            return contents
+
+        log.warning("Gave up reading metadata snapshot after %d attempts; "
+                    "the publisher is writing too frequently", _MAX_READ_ATTEMPTS)
+        return None
+
+    def close(self):
+        if self._mmap is not None:
+            self._mmap.close()
+            self._mmap = None
+        if self._fd is not None:
+            os.close(self._fd)
+            self._fd = None
+
+    def _write(self, prepared_payload, metadata_payload=None):
+        with self._lock:
+            generation, metadata_generation, metadata_length = self._read_header()[2:5]
+            if metadata_payload is not None:
+                metadata_generation, metadata_length = generation + 2, len(metadata_payload)
+            prepared_offset = HEADER_SIZE + metadata_length
+            needed = prepared_offset + len(prepared_payload)
+            if len(self._mmap) < needed:
+                if self._fd is None:
+                    raise ValueError(
+                        "Metadata snapshot needs %d bytes but the anonymous mapping only has %d; "
+                        "use a larger capacity or a file-backed snapshot" % (needed, len(self._mmap)))
+                os.ftruncate(self._fd, needed)
+                self._mmap.close()
+                self._mmap = mmap.mmap(self._fd, needed)
+
+            # an odd generation tells readers a write is in progress
+            _header_start.pack_into(self._mmap, 0, _MAGIC, _FORMAT_VERSION, generation + 1)
+            if metadata_payload is not None:
+                self._mmap[HEADER_SIZE:prepared_offset] = metadata_payload
+            self._mmap[prepared_offset:needed] = prepared_payload
+            self._write_header(generation + 2, metadata_generation, metadata_length, len(prepared_payload))
+
+    def _read_header(self):
+        return _header.unpack_from(self._mmap, 0)
+
+    def _write_header(self, generation, metadata_generation, metadata_length, prepared_length):
+        # lengths first, so that readers never see the new generation without them
+        _header_rest.pack_into(self._mmap, _header_start.size, metadata_generation, metadata_length, prepared_length)
+        _header_start.pack_into(self._mmap, 0, _MAGIC, _FORMAT_VERSION, generation)
+
+    def _map_file(self):
+        if self._mmap is not None:
+            self._mmap.close()
+        size = os.fstat(self._fd).st_size
+        if size < HEADER_SIZE:
+            # the publisher has not initialized the file yet
+            self._mmap = mmap.mmap(-1, HEADER_SIZE)
+        else:
+            self._mmap = mmap.mmap(self._fd, size, access=mmap.ACCESS_READ)
+
+
+class SnapshotContents(object):
+    """
+    A decoded view of a published :class:`.MetadataSnapshot`.
+    """
+
+    generation = None
+    """ The :attr:`.MetadataSnapshot.generation` these contents were read at. """
+
+    partitioner = None
+    """ The string name of the partitioner, if a token map was published. """
+
+    topology_digest = None
+    """
+    A digest of the hosts, locations and tokens the ring was built from.
+    See :func:`cassandra.metadata.topology_digest`.
+    """
+
+    schema_version = None
+    """ The schema version :attr:`.schema_rows` were fetched at. """
+
+    schema_rows = None
+    """
+    A tuple of keyspace, usertype, columnfamily, column and trigger rows as
+    accepted by :meth:`.Metadata.rebuild_schema()`.
+    """
+
+    prepared_statement_ids = None
+    """ A frozenset of the query ids prepared by the publisher. """
+
+    def __init__(self, generation, state, prepared=()):
+        self.generation = generation
+        self.partitioner = state.get('partitioner')
+        self.topology_digest = state.get('topology_digest')
+        self.schema_version = state.get('schema_version')
+        self.schema_rows = state.get('schema_rows')
+        self.prepared_statement_ids = frozenset(prepared)
+
+        self._hosts = state.get('hosts', ())
+        self._ring = state.get('ring')
+        self._owners = state.get('owners')
+        self._replica_maps = state.get('replica_maps', {})
+
+    def build_ring(self, token_class, metadata):
+        """
+        Returns a ``(token_to_host_owner, ring)`` tuple for a :class:`~.TokenMap`,
+        or :const:`None` if a host in the snapshot is unknown to `metadata`.
+        """
+        hosts = self._resolve_hosts(metadata)
+        if hosts is None:
+            return None
+        ring = [token_class(value) for value in _unpack_ring(self._ring)]
+        token_to_host_owner = dict(
+            (token, hosts[i]) for token, i in zip(ring, _unpack_indexes(self._owners)))
+        return token_to_host_owner, ring
+
+    def replica_map(self, strategy, ring, metadata):
+        """
+        Returns the replica map published for `strategy` (a
+        :class:`~.ReplicationStrategy`), mapping each token in `ring` to a
+        list of hosts, or :const:`None` if there is none.
+        """
+        packed = self._replica_maps.get(strategy.export_for_schema())
+        if packed is None or len(ring) != len(self._owners) // 2:
+            return None
+        hosts = self._resolve_hosts(metadata)
+        if hosts is None:
+            return None
+
+        counts, indexes = packed
+        indexes = _unpack_indexes(indexes)
+        replica_map = {}
+        offset = 0
+        for token, count in zip(ring, bytearray(counts)):
+            replica_map[token] = [hosts[i] for i in indexes[offset:offset + count]]
+            offset += count
+        return replica_map
+
+    def _resolve_hosts(self, metadata):
+        hosts = [metadata.get_host(address) for address, _, _ in self._hosts]
+        if any(host is None for host in hosts):
+            return None
+        return hosts
+
+
+def _pack_ring(ring):
+    values = [t.value for t in ring]
+    if all(isinstance(v, six.integer_types) and -(2 ** 63) <= v < 2 ** 63 for v in values):
+        return 'q', struct.pack('>%dq' % len(values), *values)
+    return 'o', values
+
+
+def _unpack_ring(packed):
+    kind, data = packed
+    if kind == 'q':
+        return struct.unpack('>%dq' % (len(data) // 8), data)
+    return data
+
+
+def _pack_indexes(indexes):
+    indexes = list(indexes)
+    return struct.pack('>%dH' % len(indexes), *indexes)
+
+
+def _unpack_indexes(data):
+    return struct.unpack('>%dH' % (len(data) // 2), data)
+
+
+def _pack_replica_map(replica_map, ring, host_index):
+    counts = bytearray()
+    indexes = []
+    for token in ring:
+        hosts = replica_map[token]
+        counts.append(len(hosts))
+        indexes.extend(host_index[h] for h in hosts)
+    return bytes(counts), _pack_indexes(indexes)
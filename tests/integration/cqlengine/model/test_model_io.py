@@ -118,6 +118,30 @@ class TestModelIO(BaseCassEngTestCase):
         assert tm2.text is None
         assert tm2._values['text'].previous_value is None
 
+    def test_model_load_selected_columns(self):
+        """
+        Tests that models loaded with some columns match models constructed from the same rows
+        """
+        tm = TestModel.create(count=8, text='123456789', a_bool=True)
+
+        for qs, loaded in ((TestModel.objects(id=tm.pk), ['id', 'count', 'text', 'a_bool']),
+                           (TestModel.objects(id=tm.pk).only(['id', 'text']), ['id', 'text']),
+                           (TestModel.objects(id=tm.pk).defer(['count']), ['id', 'text', 'a_bool'])):
+            tm2 = qs.first()
+            self.assertIsInstance(tm2, TestModel)
+            self.assertTrue(tm2._is_persisted)
+            self.assertEqual(tm2.get_changed_columns(), [])
+
+            tm3 = TestModel._construct_instance(dict((k, getattr(tm, k)) for k in loaded))
+            for cname in tm._columns.keys():
+                self.assertEqual(getattr(tm2, cname), getattr(tm3, cname))
+                self.assertEqual(tm2._values[cname].explicit, cname in loaded)
+
+        tm2 = TestModel.objects(id=tm.pk).first()
+        tm2.count = 9
+        self.assertEqual(tm2.get_changed_columns(), ['count'])
+        self.assertTrue(tm2._can_update())
+
     def test_a_sensical_error_is_raised_if_you_try_to_create_a_table_twice(self):
         """
         """
@@ -18,12 +18,13 @@ except ImportError:
     import unittest  # noqa
 
 from concurrent.futures import ThreadPoolExecutor
-from mock import Mock, ANY, call
+from mock import Mock, MagicMock, ANY, call
 
 from cassandra import OperationTimedOut
 from cassandra.protocol import ResultMessage, RESULT_KIND_ROWS
 from cassandra.cluster import ControlConnection, _Scheduler
 from cassandra.pool import Host
+from cassandra.preparedcache import PreparedStatementCache
 from cassandra.policies import (SimpleConvictionPolicy, RoundRobinPolicy,
                                 ConstantReconnectionPolicy)
 
@@ -51,7 +52,7 @@ class MockMetadata(object):
     def all_hosts(self):
         return self.hosts.values()
 
-    def rebuild_token_map(self, partitioner, token_map):
+    def rebuild_token_map(self, partitioner, token_map, snapshot=None, compute_digest=False):
         self.partitioner = partitioner
         self.token_map = token_map
 
@@ -64,6 +65,8 @@ class MockCluster(object):
     down_host = None
     contact_points = []
     is_shutdown = False
+    metadata_snapshot = None
+    prepared_statement_cache = None
 
     def __init__(self):
         self.metadata = MockMetadata()
@@ -339,6 +342,41 @@ class ControlConnectionTest(unittest.TestCase):
         self.assertEqual(self.connection.wait_for_responses.call_count, self.cluster.max_schema_agreement_wait / self.control_connection._timeout)
         self.assertEqual(self.connection.wait_for_responses.call_args[1]['timeout'], self.control_connection._timeout)
 
+    def test_refresh_schema_from_snapshot(self):
+        """
+        Schema rows published for the current schema version are used instead of querying
+        """
+        rows = ([{'keyspace_name': 'ks'}], [], [], [], [])
+        contents = Mock(schema_version='a', schema_rows=rows, generation=2)
+        self.cluster.metadata_snapshot = Mock(is_publisher=False, load=Mock(return_value=contents))
+        self.cluster.metadata.rebuild_schema = Mock()
+        preloaded_results = self._get_matching_schema_preloaded_results()
+
+        self.assertTrue(self.control_connection._refresh_schema(self.connection, preloaded_results=preloaded_results))
+        self.cluster.metadata.rebuild_schema.assert_called_once_with(*rows)
+        self.assertEqual(self.connection.wait_for_responses.call_count, 0)
+
+        # a different schema version falls back to querying
+        contents.schema_version = 'b'
+        self.connection.wait_for_responses.side_effect = OperationTimedOut()
+        self.assertRaises(OperationTimedOut, self.control_connection._refresh_schema,
+                          self.connection, preloaded_results=preloaded_results)
+        self.assertEqual(self.connection.wait_for_responses.call_count, 1)
+        self.assertEqual(self.cluster.metadata.rebuild_schema.call_count, 1)
+
+    def test_refresh_schema_updates_prepared_statement_cache(self):
+        """
+        The agreed schema version is passed on to the prepared statement cache
+        """
+        # an empty cache has a length of zero, which must not disable it
+        self.cluster.prepared_statement_cache = MagicMock(spec=PreparedStatementCache)
+        self.cluster.prepared_statement_cache.__len__.return_value = 0
+        self.cluster.metadata.cluster_name = 'test_cluster'
+        self.connection.wait_for_responses.side_effect = OperationTimedOut()
+        self.assertRaises(OperationTimedOut, self.control_connection._refresh_schema,
+                          self.connection, preloaded_results=self._get_matching_schema_preloaded_results())
+        self.cluster.prepared_statement_cache.set_schema_version.assert_called_once_with('test_cluster', 'a')
+
     def test_handle_topology_change(self):
         event = {
             'change_type': 'NEW_NODE',
@@ -17,12 +17,12 @@ try:
 except ImportError:
     import unittest # noqa
 
-from mock import Mock, NonCallableMagicMock
+from mock import Mock, NonCallableMagicMock, patch
 from threading import Thread, Event
 
 from cassandra.cluster import Session
 from cassandra.connection import Connection
-from cassandra.pool import Host, HostConnectionPool, NoConnectionsAvailable
+from cassandra.pool import Host, HostConnection, HostConnectionPool, NoConnectionsAvailable
 from cassandra.policies import HostDistance, SimpleConvictionPolicy
 
 
@@ -162,6 +162,97 @@ class HostConnectionPoolTests(unittest.TestCase):
         self.assertRaises(NoConnectionsAvailable, pool.borrow_connection, 0)
         session.submit.assert_called_once_with(pool._create_new_connection)
 
+    def test_power_of_two_choices(self):
+        host = Mock(spec=Host, address='ip1')
+        session = self.make_session()
+        conns = [NonCallableMagicMock(spec=Connection, in_flight=in_flight, is_defunct=False, is_closed=False, max_request_id=100)
+                 for in_flight in (5, 3, 100, 1)]
+        session.cluster.connection_factory.side_effect = conns
+        session.cluster.get_core_connections_per_host.return_value = 4
+        session.cluster.get_max_requests_per_connection.return_value = 100
+        session.cluster.get_max_connections_per_host.return_value = 4
+
+        pool = HostConnectionPool(host, HostDistance.LOCAL, session)
+
+        # picks the less busy of the two sampled connections, not the least busy overall
+        with patch('cassandra.pool.random', side_effect=[0.0, 0.0]):
+            c, _ = pool.borrow_connection(timeout=0.01)
+        self.assertIs(c, conns[1])
+        self.assertEqual(4, conns[1].in_flight)
+
+        # if both sampled connections are full, the least busy one is used
+        conns[0].in_flight = 100
+        conns[1].in_flight = 100
+        with patch('cassandra.pool.random', side_effect=[0.0, 0.0]):
+            c, _ = pool.borrow_connection(timeout=0.01)
+        self.assertIs(c, conns[3])
+        self.assertEqual(2, conns[3].in_flight)
+        self.assertFalse(conns[0].lock.__enter__.called)
+
+        pool.return_connection(c)
+        self.assertEqual(1, conns[3].in_flight)
+
+    def test_no_spawn_while_any_connection_has_capacity(self):
+        host = Mock(spec=Host, address='ip1')
+        session = self.make_session()
+        conns = [NonCallableMagicMock(spec=Connection, in_flight=in_flight, is_defunct=False, is_closed=False, max_request_id=100)
+                 for in_flight in (50, 40, 0)]
+        session.cluster.connection_factory.side_effect = conns
+        session.cluster.get_core_connections_per_host.return_value = 3
+        session.cluster.get_max_requests_per_connection.return_value = 10
+        session.cluster.get_max_connections_per_host.return_value = 4
+
+        pool = HostConnectionPool(host, HostDistance.LOCAL, session)
+
+        # both sampled connections are over max_requests, but the third is idle
+        with patch('cassandra.pool.random', side_effect=[0.0, 0.0]):
+            c, _ = pool.borrow_connection(timeout=0.01)
+        self.assertIs(c, conns[1])
+        self.assertFalse(session.submit.called)
+
+        # once every connection is over max_requests, the pool grows
+        conns[2].in_flight = 10
+        with patch('cassandra.pool.random', side_effect=[0.0, 0.0]):
+            pool.borrow_connection(timeout=0.01)
+        session.submit.assert_called_once_with(pool._create_new_connection)
+
+    def test_return_without_waiters(self):
+        host = Mock(spec=Host, address='ip1')
+        session = self.make_session()
+        conn = NonCallableMagicMock(spec=Connection, in_flight=0, is_defunct=False, is_closed=False, max_request_id=100)
+        session.cluster.connection_factory.return_value = conn
+
+        pool = HostConnectionPool(host, HostDistance.LOCAL, session)
+        pool._conn_available_condition.notify = Mock()
+
+        c, _ = pool.borrow_connection(timeout=0.01)
+        pool.return_connection(c)
+        self.assertFalse(pool._conn_available_condition.notify.called)
+
+        pool._waiters = 1
+        c, _ = pool.borrow_connection(timeout=0.01)
+        pool.return_connection(c)
+        pool._conn_available_condition.notify.assert_called_once_with()
+
+    def test_host_connection_borrow_and_return(self):
+        host = Mock(spec=Host, address='ip1')
+        session = self.make_session()
+        conn = NonCallableMagicMock(spec=Connection, in_flight=0, is_defunct=False, is_closed=False, max_request_id=100)
+        session.cluster.connection_factory.return_value = conn
+
+        pool = HostConnection(host, HostDistance.LOCAL, session)
+        c, request_id = pool.borrow_connection(timeout=0.01)
+        self.assertIs(c, conn)
+        self.assertEqual(1, conn.in_flight)
+        pool.return_connection(c)
+        self.assertEqual(0, conn.in_flight)
+
+        # a full connection is rejected without taking its lock
+        conn.lock.reset_mock()
+        conn.in_flight = conn.max_request_id
+        self.assertRaises(NoConnectionsAvailable, pool.borrow_connection, 0)
+        self.assertFalse(conn.lock.__enter__.called)
+
     def test_return_defunct_connection(self):
         host = Mock(spec=Host, address='ip1')
         session = self.make_session()
@@ -27,7 +27,7 @@ from cassandra.metadata import (Murmur3Token, MD5Token,
                                 LocalStrategy, NoMurmur3, protect_name,
                                 protect_names, protect_value, is_valid_name,
                                 UserType, KeyspaceMetadata, Metadata,
-                                _UnknownStrategy)
+                                LazyMetadataMap, _UnknownStrategy)
 from cassandra.policies import SimpleConvictionPolicy
 from cassandra.pool import Host
 
@@ -291,6 +291,108 @@ CREATE TYPE test.b (
         return Mock(**{'cassname': cassname, 'typename': typename, 'cql_parameterized_type.return_value': typename})
 
 
+class LazySchemaTest(unittest.TestCase):
+
+    def keyspace_row(self, ks):
+        return {'keyspace_name': ks, 'durable_writes': True,
+                'strategy_class': 'SimpleStrategy', 'strategy_options': '{"replication_factor": "1"}'}
+
+    def table_rows(self, ks, table):
+        cf_row = {'keyspace_name': ks, 'columnfamily_name': table,
+                  'comparator': 'org.apache.cassandra.db.marshal.CompositeType(org.apache.cassandra.db.marshal.UTF8Type)',
+                  'key_validator': 'org.apache.cassandra.db.marshal.Int32Type',
+                  'key_aliases': '["k"]', 'column_aliases': '[]',
+                  'default_validator': 'org.apache.cassandra.db.marshal.BytesType'}
+        col_rows = [{'keyspace_name': ks, 'columnfamily_name': table, 'column_name': 'v',
+                     'validator': 'org.apache.cassandra.db.marshal.Int32Type', 'type': 'regular',
+                     'index_name': '%s_v_idx' % table, 'index_type': 'COMPOSITES', 'index_options': '{}'}]
+        return cf_row, col_rows
+
+    def build(self, tables=('a', 'b')):
+        metadata = Metadata()
+        metadata._build_table_metadata = Mock(wraps=metadata._build_table_metadata)
+        cf_rows, col_rows = [], []
+        for table in tables:
+            cf_row, table_col_rows = self.table_rows('ks', table)
+            cf_rows.append(cf_row)
+            col_rows.extend(table_col_rows)
+        metadata.rebuild_schema([self.keyspace_row('ks')], [], cf_rows, col_rows, [])
+        return metadata
+
+    def test_tables_built_on_first_access(self):
+        metadata = self.build()
+        keyspace = metadata.keyspaces['ks']
+        self.assertFalse(metadata._build_table_metadata.called)
+        self.assertEqual(sorted(keyspace.tables), ['a', 'b'])
+        self.assertIn('a', keyspace.tables)
+        self.assertEqual(sorted(keyspace.indexes), ['a_v_idx', 'b_v_idx'])
+        self.assertFalse(metadata._build_table_metadata.called)
+
+        table = keyspace.tables['a']
+        self.assertEqual(table.name, 'a')
+        self.assertEqual(list(table.columns), ['k', 'v'])
+        self.assertEqual(metadata._build_table_metadata.call_count, 1)
+        self.assertIs(keyspace.tables['a'], table)
+        self.assertIs(keyspace.indexes['a_v_idx'], table.indexes['a_v_idx'])
+        self.assertFalse(keyspace.tables.is_loaded('b'))
+
+        # looking up an index builds its table
+        index = keyspace.indexes['b_v_idx']
+        self.assertIs(index.column.table, keyspace.tables['b'])
+        self.assertEqual(metadata._build_table_metadata.call_count, 2)
+
+    def test_table_changed(self):
+        metadata = self.build()
+        keyspace = metadata.keyspaces['ks']
+        table_a = keyspace.tables['a']
+
+        cf_row, col_rows = self.table_rows('ks', 'b')
+        col_rows[0]['index_name'] = 'renamed_idx'
+        metadata.table_changed('ks', 'b', [cf_row], col_rows, [])
+        self.assertIs(keyspace.tables['a'], table_a)
+        self.assertEqual(sorted(keyspace.indexes), ['a_v_idx', 'renamed_idx'])
+        self.assertEqual(metadata._build_table_metadata.call_count, 1)
+        self.assertEqual(list(keyspace.tables['b'].indexes), ['renamed_idx'])
+
+        metadata.table_changed('ks', 'a', [], [], [])
+        self.assertEqual(list(keyspace.tables), ['b'])
+        self.assertEqual(list(keyspace.indexes), ['renamed_idx'])
+
+    def test_keyspace_changed_keeps_tables(self):
+        metadata = self.build()
+        metadata.keyspace_changed('ks', [self.keyspace_row('ks')])
+        keyspace = metadata.keyspaces['ks']
+        self.assertEqual(keyspace.tables['b'].name, 'b')
+        self.assertEqual(sorted(keyspace.indexes), ['a_v_idx', 'b_v_idx'])
+        self.assertIn('CREATE TABLE ks.a', keyspace.export_as_string())
+
+    def test_lazy_map_keys(self):
+        lazy = LazyMetadataMap()
+        seen = []
+
+        def loader():
+            # a concurrent reader sees the key while it is being loaded
+            seen.append(('a' in lazy, len(lazy)))
+            return 1
+
+        lazy.set_loader('a', loader)
+        lazy['b'] = 2
+        lazy.set_loader('b', lambda: 3)
+        self.assertEqual(len(lazy), 2)
+        self.assertEqual(lazy['a'], 1)
+        self.assertEqual(seen, [(True, 2)])
+        self.assertTrue(lazy.is_loaded('a'))
+        self.assertEqual((len(lazy), sorted(lazy)), (2, ['a', 'b']))
+
+        lazy['a'] = 4
+        lazy.discard('b')
+        lazy.discard('b')
+        self.assertEqual((len(lazy), sorted(lazy)), (1, ['a']))
+        del lazy['a']
+        self.assertRaises(KeyError, lazy.__delitem__, 'a')
+        self.assertEqual(len(lazy), 0)
+
+
 class UserTypesTest(unittest.TestCase):
 
     def test_as_cql_query(self):
@@ -0,0 +1,191 @@
+# Copyright 2013-2015 DataStax, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+try:
+    import unittest2 as unittest
+except ImportError:
+    import unittest  # noqa
+
+import os
+import shutil
+import tempfile
+
+from cassandra.cqltypes import (Int32Type, UTF8Type, ListType, MapType, TupleType,
+                                UserType, lookup_casstype)
+from cassandra.preparedcache import PreparedStatementCache
+from cassandra.query import PreparedStatement
+
+
+class Address(object):
+
+    def __init__(self, street=None, zipcode=None):
+        self.street = street
+        self.zipcode = zipcode
+
+
+def make_statements():
+    address_type = UserType.make_udt_class(
+        'ks', 'address', (('street', UTF8Type), ('zipcode', Int32Type)), None)
+    insert = PreparedStatement(
+        [('ks', 'users', 'id', Int32Type),
+         ('ks', 'users', 'emails', ListType.apply_parameters([UTF8Type])),
+         ('ks', 'users', 'scores', MapType.apply_parameters([UTF8Type, Int32Type])),
+         ('ks', 'users', 'point', TupleType.apply_parameters([Int32Type, Int32Type])),
+         ('ks', 'users', 'address', address_type),
+         ('ks', 'users', 'custom', lookup_casstype('org.example.CustomType'))],
+        b'\x01\x02', [0], "INSERT INTO users (id, emails, scores, point, address, custom) VALUES (?, ?, ?, ?, ?, ?)",
+        'ks', 3)
+    select = PreparedStatement([], b'\x03\x04', None, "SELECT * FROM ks.users", None, 3)
+    return insert, select
+
+
+class PreparedStatementCacheTest(unittest.TestCase):
+
+    def setUp(self):
+        self.tmpdir = tempfile.mkdtemp()
+        self.path = os.path.join(self.tmpdir, 'prepared')
+
+    def tearDown(self):
+        shutil.rmtree(self.tmpdir)
+
+    def test_missing_file(self):
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v1')
+        self.assertEqual(len(cache), 0)
+        self.assertIsNone(cache.get("SELECT * FROM ks.users", None, 3))
+
+    def test_save_before_schema_version(self):
+        cache = PreparedStatementCache(self.path)
+        for statement in make_statements():
+            self.assertFalse(cache.add(statement, None, None))
+        cache.save()
+        self.assertFalse(os.path.exists(self.path))
+
+    def test_round_trip(self):
+        insert, select = make_statements()
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v1')
+        self.assertTrue(cache.add(insert, 'cluster', 'v1'))
+        self.assertTrue(cache.add(select, 'cluster', 'v1'))
+        cache.save()
+        self.assertEqual(os.listdir(self.tmpdir), ['prepared'])
+
+        # nothing is written when nothing changed
+        os.unlink(self.path)
+        cache.save()
+        self.assertFalse(os.path.exists(self.path))
+        cache.add(insert, 'cluster', 'v1')
+        cache.save()
+
+        cache = PreparedStatementCache(self.path)
+        # unusable until the schema version is confirmed
+        self.assertIsNone(cache.get(insert.query_string, 'ks', 3))
+        cache.set_schema_version('cluster', 'v1')
+        self.assertEqual(len(cache), 2)
+
+        cached = cache.get(insert.query_string, 'ks', 3, {'ks': {'address': Address}})
+        self.assertEqual(cached.query_id, insert.query_id)
+        self.assertEqual(cached.query_string, insert.query_string)
+        self.assertEqual(cached.keyspace, 'ks')
+        self.assertEqual(cached.protocol_version, 3)
+        self.assertEqual(cached.routing_key_indexes, [0])
+        self.assertEqual([c[:3] for c in cached.column_metadata], [c[:3] for c in insert.column_metadata])
+        self.assertEqual([c[3].cass_parameterized_type(full=True) for c in cached.column_metadata],
+                         [c[3].cass_parameterized_type(full=True) for c in insert.column_metadata])
+
+        address_type = cached.column_metadata[4][3]
+        self.assertEqual((address_type.keyspace, address_type.typename), ('ks', 'address'))
+        self.assertEqual(list(address_type.fieldnames), ['street', 'zipcode'])
+
+        bound = cached.bind((1, ['a@b.c'], {'x': 1}, (1, 2), Address('main', 12345), b'\x00'))
+        self.assertEqual(bound.values, insert.bind((1, ['a@b.c'], {'x': 1}, (1, 2), Address('main', 12345), b'\x00')).values)
+
+        cached = cache.get(select.query_string, None, 3)
+        self.assertEqual(cached.query_id, select.query_id)
+        self.assertEqual(cached.column_metadata, [])
+        self.assertIsNone(cached.routing_key_indexes)
+
+        # keyed by keyspace and protocol version as well as query
+        self.assertIsNone(cache.get(insert.query_string, None, 3))
+        self.assertIsNone(cache.get(insert.query_string, 'ks', 2))
+
+    def test_schema_version_mismatch(self):
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v1')
+        for statement in make_statements():
+            cache.add(statement, 'cluster', 'v1')
+        cache.save()
+
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v2')
+        self.assertEqual(len(cache), 0)
+
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('other_cluster', 'v1')
+        self.assertEqual(len(cache), 0)
+
+        # a later schema change drops entries that were usable
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v1')
+        self.assertEqual(len(cache), 2)
+        cache.set_schema_version('cluster', 'v2')
+        self.assertEqual(len(cache), 0)
+        cache.set_schema_version('cluster', 'v1')
+        self.assertEqual(len(cache), 0)
+
+    def test_stale_statements_not_saved(self):
+        insert, select = make_statements()
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v1')
+        cache.add(insert, 'cluster', 'v1')
+
+        # prepared before the schema changed, so its metadata may be stale
+        cache.set_schema_version('cluster', 'v2')
+        self.assertFalse(cache.add(select, 'cluster', 'v1'))
+        self.assertTrue(cache.add(select, 'cluster', 'v2'))
+        cache.save()
+
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v2')
+        self.assertEqual(len(cache), 1)
+        self.assertIsNone(cache.get(insert.query_string, 'ks', 3))
+        self.assertIsNotNone(cache.get(select.query_string, None, 3))
+
+    def test_discard(self):
+        insert, select = make_statements()
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v1')
+        cache.add(insert, 'cluster', 'v1')
+        cache.add(select, 'cluster', 'v1')
+        cache.save()
+
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v1')
+        cache.discard(insert.query_id)
+        self.assertIsNone(cache.get(insert.query_string, 'ks', 3))
+        self.assertIsNotNone(cache.get(select.query_string, None, 3))
+
+        cache.save()
+        cache = PreparedStatementCache(self.path)
+        cache.set_schema_version('cluster', 'v1')
+        self.assertEqual(len(cache), 1)
+
+    def test_corrupt_file(self):
+        for contents in (b'', b'CPSC', b'XXXX\x01\x00\x00\x00\x00\x00\x00\x00',
+                         b'CPSC\x01\x00\x00\x00\x00\x00\x00\x10garbage'):
+            with open(self.path, 'wb') as f:
+                f.write(contents)
+            cache = PreparedStatementCache(self.path)
+            cache.set_schema_version('cluster', 'v1')
+            self.assertEqual(len(cache), 0)
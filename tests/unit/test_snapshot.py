@@ -0,0 +1,198 @@
+# Copyright 2013-2015 DataStax, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+try:
+    import unittest2 as unittest
+except ImportError:
+    import unittest  # noqa
+
+import os
+import shutil
+import tempfile
+
+from mock import Mock
+
+from cassandra.metadata import KeyspaceMetadata, Metadata, Murmur3Token
+from cassandra.policies import SimpleConvictionPolicy
+from cassandra.pool import Host
+from cassandra.snapshot import MetadataSnapshot
+
+TOKENS = {
+    '10.0.0.1': ('dc1', ['-9000', '-100', '5000']),
+    '10.0.0.2': ('dc1', ['-8000', '0', '6000']),
+    '10.0.0.3': ('dc2', ['-7000', '100', '7000']),
+    '10.0.0.4': ('dc2', ['-6000', '200', '8000']),
+}
+
+
+def make_metadata(tokens=TOKENS):
+    metadata = Metadata()
+    token_map = {}
+    for address, (dc, host_tokens) in tokens.items():
+        host = Host(address, SimpleConvictionPolicy)
+        host.set_location_info(dc, 'rack1')
+        metadata.add_or_return_host(host)
+        token_map[host] = host_tokens
+
+    metadata.keyspaces['simple'] = KeyspaceMetadata(
+        'simple', True, 'SimpleStrategy', {'replication_factor': '2'})
+    metadata.keyspaces['nts'] = KeyspaceMetadata(
+        'nts', True, 'NetworkTopologyStrategy', {'dc1': '2', 'dc2': '1'})
+    metadata.keyspaces['nts_copy'] = KeyspaceMetadata(
+        'nts_copy', True, 'NetworkTopologyStrategy', {'dc1': '2', 'dc2': '1'})
+    metadata.rebuild_token_map('Murmur3Partitioner', token_map, compute_digest=True)
+    return metadata, token_map
+
+
+def replica_addresses(metadata, keyspace):
+    token_map = metadata.token_map
+    return [[h.address for h in token_map.get_replicas(keyspace, token)]
+            for token in token_map.ring]
+
+
+class MetadataSnapshotTest(unittest.TestCase):
+
+    def setUp(self):
+        self.tmpdir = tempfile.mkdtemp()
+        self.path = os.path.join(self.tmpdir, 'snapshot')
+
+    def tearDown(self):
+        shutil.rmtree(self.tmpdir)
+
+    def test_empty(self):
+        snapshot = MetadataSnapshot(capacity=4096)
+        self.assertTrue(snapshot.is_publisher)
+        self.assertEqual(snapshot.generation, 0)
+        self.assertIsNone(snapshot.load())
+
+        MetadataSnapshot(self.path)
+        reader = MetadataSnapshot.attach(self.path)
+        self.assertFalse(reader.is_publisher)
+        self.assertIsNone(reader.load())
+        self.assertRaises(RuntimeError, reader.publish, Metadata())
+
+    def test_publish_and_load(self):
+        metadata, _ = make_metadata()
+        publisher = MetadataSnapshot(self.path, capacity=64)
+        rows = ([{'keyspace_name': 'simple'}], [], [], [], [])
+        publisher.set_schema_rows('abc', rows)
+        publisher.set_prepared_statements([Mock(query_id=b'\x01\x02', keyspace='simple', query_string='SELECT')])
+        publisher.publish(metadata)
+        self.assertEqual(publisher.generation, 2)
+
+        reader = MetadataSnapshot.attach(self.path)
+        contents = reader.load()
+        self.assertEqual(contents.generation, 2)
+        self.assertEqual(contents.partitioner, 'Murmur3Partitioner')
+        self.assertEqual(contents.topology_digest, metadata.token_map.topology_digest)
+        self.assertEqual(contents.schema_version, 'abc')
+        self.assertEqual(contents.schema_rows, rows)
+        self.assertEqual(contents.prepared_statement_ids, frozenset([b'\x01\x02']))
+
+        # cached until the generation changes
+        self.assertIs(reader.load(), contents)
+        publisher.publish(metadata)
+        self.assertEqual(publisher.generation, 4)
+        self.assertEqual(reader.load().generation, 4)
+
+        # publishing prepared statement ids leaves the rest in place
+        state = reader._loaded_state
+        publisher.set_prepared_statements([Mock(query_id=b'\x01\x02'), Mock(query_id=b'\x03\x04')])
+        publisher.publish_prepared()
+        self.assertEqual(publisher.generation, 6)
+        contents = reader.load()
+        self.assertEqual(contents.generation, 6)
+        self.assertIs(reader._loaded_state, state)
+        self.assertEqual(contents.prepared_statement_ids, frozenset([b'\x01\x02', b'\x03\x04']))
+        self.assertEqual(contents.schema_rows, rows)
+        self.assertEqual(contents.topology_digest, metadata.token_map.topology_digest)
+
+    def test_torn_header(self):
+        metadata, _ = make_metadata()
+        publisher = MetadataSnapshot(self.path, capacity=64)
+        publisher.set_schema_rows('abc', ([], [], [], [], []))
+        publisher.publish(metadata)
+
+        # the new generation seen before the lengths written with it
+        reader = MetadataSnapshot.attach(self.path)
+        header = reader._read_header()
+        torn = header[:3] + (0, 0, 0)
+        reader._read_header = Mock(side_effect=[torn] + [header] * 3)
+        contents = reader.load()
+        self.assertEqual(contents.schema_version, 'abc')
+        self.assertEqual(contents.topology_digest, metadata.token_map.topology_digest)
+
+    def test_reuse_ring_and_replica_maps(self):
+        metadata, _ = make_metadata()
+        publisher = MetadataSnapshot(capacity=1024 * 1024)
+        publisher.publish(metadata)
+        contents = publisher.load()
+
+        worker_metadata, token_map = make_metadata()
+        worker_metadata.rebuild_token_map('Murmur3Partitioner', token_map, snapshot=contents)
+        self.assertIs(worker_metadata.token_map._snapshot, contents)
+        self.assertEqual(worker_metadata.token_map.ring, metadata.token_map.ring)
+        for token, host in worker_metadata.token_map.token_to_host_owner.items():
+            self.assertIs(host, worker_metadata.get_host(host.address))
+            self.assertEqual(host.address, metadata.token_map.token_to_host_owner[token].address)
+
+        strategy = worker_metadata.keyspaces['nts'].replication_strategy
+        strategy.make_token_replica_map = Mock()
+        for keyspace in ('simple', 'nts', 'nts_copy'):
+            self.assertEqual(replica_addresses(worker_metadata, keyspace), replica_addresses(metadata, keyspace))
+        self.assertFalse(strategy.make_token_replica_map.called)
+
+    def test_ignore_mismatched_topology(self):
+        metadata, _ = make_metadata()
+        publisher = MetadataSnapshot(capacity=1024 * 1024)
+        publisher.publish(metadata)
+
+        tokens = dict(TOKENS)
+        tokens['10.0.0.5'] = ('dc2', ['-5000', '300', '9000'])
+        worker_metadata, token_map = make_metadata(tokens)
+        worker_metadata.rebuild_token_map('Murmur3Partitioner', token_map, snapshot=publisher.load())
+        self.assertIsNone(worker_metadata.token_map._snapshot)
+        self.assertEqual(len(worker_metadata.token_map.ring), 15)
+        self.assertIn(Murmur3Token(9000), worker_metadata.token_map.ring)
+
+    def test_anonymous_capacity(self):
+        metadata, _ = make_metadata()
+        publisher = MetadataSnapshot(capacity=64)
+        self.assertRaises(ValueError, publisher.publish, metadata)
+        self.assertEqual(publisher.generation, 0)
+
+    @unittest.skipUnless(hasattr(os, 'fork'), "requires os.fork()")
+    def test_forked_reader(self):
+        metadata, _ = make_metadata()
+        snapshot = MetadataSnapshot(capacity=1024 * 1024)
+        snapshot.publish(metadata)
+
+        read_fd, write_fd = os.pipe()
+        pid = os.fork()
+        if pid == 0:
+            status = 1
+            try:
+                os.close(read_fd)
+                contents = snapshot.load()
+                if not snapshot.is_publisher and contents.topology_digest == metadata.token_map.topology_digest:
+                    status = 0
+                os.write(write_fd, b'x')
+            finally:
+                os._exit(status)
+
+        os.close(write_fd)
+        os.read(read_fd, 1)
+        os.close(read_fd)
+        _, status = os.waitpid(pid, 0)
+        self.assertEqual(os.WEXITSTATUS(status), 0)